@@ -0,0 +1,128 @@
+#include "bench.h"
+
+#include <iostream>
+
+#include <glad.h>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <frame_constants.h>
+#include <depth_sort.h>
+#include <generator.h>
+#include <gl_resources.h>
+#include <point_modes.h>
+#include <shader.h>
+
+#define BENCH_POINTS 1000000
+#define BENCH_WIDTH 3840
+#define BENCH_HEIGHT 2160
+#define WARMUP_FRAMES 1
+#define MEASURED_FRAMES 5
+
+/**
+ * Analytic anti-aliased points at 1x against alpha-to-coverage with 4x and 8x
+ * MSAA, at 4K. The analytic mode is measured with and without the per-frame
+ * CPU depth sort. Framebuffer memory is reported next to frame time; MSAA
+ * modes include the resolve blit to a single-sampled target.
+ */
+void benchAnalyticAA(BenchContext& context) {
+    std::vector<vec3local> points(BENCH_POINTS);
+    populate3Darray(points.data(), BENCH_POINTS, 0.9f);
+
+    Buffer pointBuffer, indexBuffer;
+    pointBuffer.storage(sizeof(vec3local) * BENCH_POINTS, points.data());
+    VertexArray vertexArray;
+    vertexArray.attribute(0, pointBuffer.ID, 3, GL_FLOAT, sizeof(vec3local));
+    vertexArray.elementBuffer(indexBuffer.ID);
+
+    int maxSamples = 0;
+    glGetIntegerv(GL_MAX_SAMPLES, &maxSamples);
+
+    // single-sampled target that MSAA modes resolve into
+    Framebuffer resolveFramebuffer;
+    Renderbuffer resolveColor;
+    resolveColor.storage(GL_RGBA8, BENCH_WIDTH, BENCH_HEIGHT);
+    resolveFramebuffer.attach(GL_COLOR_ATTACHMENT0, resolveColor);
+
+    FrameConstantsBuffer frameConstantsBuffer;
+    FrameConstants frameConstants;
+    frameConstants.viewport = glm::vec4(BENCH_WIDTH, BENCH_HEIGHT, 1.0f / BENCH_WIDTH, 1.0f / BENCH_HEIGHT);
+    std::vector<uint32_t> indices;
+
+    struct Variant {
+        const char* name;
+        PointMode mode;
+        int samples;
+        bool sorted;
+    };
+    const Variant variants[] = {
+        {"analytic-1x", POINT_MODE_ANALYTIC, 0, false},
+        {"analytic-1x-sorted", POINT_MODE_ANALYTIC, 0, true},
+        {"a2c-msaa-4x", POINT_MODE_ALPHA_TO_COVERAGE, 4, false},
+        {"a2c-msaa-8x", POINT_MODE_ALPHA_TO_COVERAGE, 8, false},
+    };
+
+    glViewport(0, 0, BENCH_WIDTH, BENCH_HEIGHT);
+    for (const Variant& variant : variants) {
+        if (variant.samples > maxSamples) {
+            std::cout << "analytic_aa: " << variant.name << " skipped, GL_MAX_SAMPLES is " << maxSamples << std::endl;
+            continue;
+        }
+
+        Framebuffer multisampled;
+        Renderbuffer renderbuffers[2];
+        if (variant.samples > 0) {
+            renderbuffers[0].storage(GL_RGBA8, BENCH_WIDTH, BENCH_HEIGHT, variant.samples);
+            renderbuffers[1].storage(GL_DEPTH_COMPONENT24, BENCH_WIDTH, BENCH_HEIGHT, variant.samples);
+            multisampled.attach(GL_COLOR_ATTACHMENT0, renderbuffers[0]);
+            multisampled.attach(GL_DEPTH_ATTACHMENT, renderbuffers[1]);
+        }
+        const Framebuffer& framebuffer = variant.samples > 0 ? multisampled : resolveFramebuffer;
+
+        Program shader(Shader((context.shaderDir / "vertex.glsl").string(),
+                              (context.shaderDir / "fragment.glsl").string(),
+                              {{4, "POINT_MODE", (float)variant.mode}}));
+        applyPointMode(variant.mode);
+
+        std::vector<double> frameTimes;
+        for (int frame = 0; frame < WARMUP_FRAMES + MEASURED_FRAMES; frame++) {
+            double start = nowSeconds();
+            framebuffer.bind();
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            frameConstants.rotation = glm::rotate(glm::mat4(1.0f), frame * 0.1f, glm::normalize(glm::vec3(-2, 3, 1)));
+            frameConstantsBuffer.update(frameConstants);
+            shader.use();
+            vertexArray.bind();
+            if (variant.sorted) {
+                depthSortCPU(points.data(), BENCH_POINTS, frameConstants.rotation, indices);
+                indexBuffer.data(sizeof(uint32_t) * BENCH_POINTS, indices.data(), GL_STREAM_DRAW);
+                glDrawElements(GL_POINTS, BENCH_POINTS, GL_UNSIGNED_INT, NULL);
+            } else {
+                glDrawArrays(GL_POINTS, 0, BENCH_POINTS);
+            }
+            if (variant.samples > 0) {
+                glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer.ID);
+                glBindFramebuffer(GL_DRAW_FRAMEBUFFER, resolveFramebuffer.ID);
+                glBlitFramebuffer(0, 0, BENCH_WIDTH, BENCH_HEIGHT, 0, 0, BENCH_WIDTH, BENCH_HEIGHT, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+            }
+            glFinish();
+            double finished = nowSeconds();
+            if (frame >= WARMUP_FRAMES) {
+                frameTimes.push_back(finished - start);
+            }
+        }
+        applyPointMode(POINT_MODE_DISCARD);
+        glBindFramebuffer(GL_FRAMEBUFFER, context.framebuffer);
+
+        // MSAA: RGBA8 color + 24-bit depth (stored as 32 bits) per sample, plus the
+        // resolve target. The blended 1x mode needs only its color buffer.
+        double bytesPerPixel = variant.samples > 0 ? variant.samples * 8 + 4 : 4;
+        double memory = (double)BENCH_WIDTH * BENCH_HEIGHT * bytesPerPixel;
+        std::string params = std::string("4K N=1M ") + variant.name;
+        context.results.push_back({"analytic_aa/frame", params, median(frameTimes) * 1e3, "ms"});
+        context.results.push_back({"analytic_aa/framebuffer", params, memory / (1024.0 * 1024.0), "MiB"});
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, context.framebuffer);
+    glViewport(0, 0, context.width, context.height);
+} /* benchAnalyticAA() */
@@ -0,0 +1,68 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include <filesystem>
+namespace fs = std::filesystem;
+
+#include <point_sphere.h>
+
+// One measurement reported by a benchmark case
+struct BenchResult {
+    std::string name;       // benchmark case
+    std::string params;     // e.g. "K=1000"
+    double value;
+    std::string unit;
+};
+
+// Everything a benchmark case needs from the harness
+struct BenchContext {
+    fs::path shaderDir;
+    int width, height;
+    unsigned int framebuffer;       // the window's (0) or the headless context's
+    PointSphereConfig sphere;       // from --config and --NAME VALUE, for the cases that draw the whole sphere
+    std::string sphereParams;       // the settings that differ from the defaults
+    std::vector<BenchResult> results;
+    std::vector<std::string> failures;      // correctness checks that failed; the bench then exits with 1
+};
+
+inline double nowSeconds() {
+    using clock = std::chrono::steady_clock;
+    return std::chrono::duration<double>(clock::now().time_since_epoch()).count();
+} /* nowSeconds() */
+
+inline double median(std::vector<double> samples) {
+    if (samples.empty()) {
+        return 0.0;
+    }
+    std::nth_element(samples.begin(), samples.begin() + samples.size() / 2, samples.end());
+    return samples[samples.size() / 2];
+} /* median() */
+
+// Benchmark cases, one per source file
+void benchGeneration(BenchContext& context);
+void benchUpload(BenchContext& context);
+void benchInstanced(BenchContext& context);
+void benchCulled(BenchContext& context);
+void benchHemisphere(BenchContext& context);
+void benchPointModes(BenchContext& context);
+void benchAnalyticAA(BenchContext& context);
+void benchOIT(BenchContext& context);
+void benchGpuSort(BenchContext& context);
+void benchStreaming(BenchContext& context);
+void benchState(BenchContext& context);
+void benchReadback(BenchContext& context);
+void benchCpuRaster(BenchContext& context);
+void benchProfiler(BenchContext& context);
+void benchTrace(BenchContext& context);
+void benchPacing(BenchContext& context);
+void benchLatency(BenchContext& context);
+void benchRotation(BenchContext& context);
+void benchSphere(BenchContext& context);
+void benchOITViewport(BenchContext& context);
+
+#endif  // BENCH_H
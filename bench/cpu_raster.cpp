@@ -0,0 +1,97 @@
+#include "bench.h"
+
+#include <glad.h>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <cpu_rasterizer.h>
+#include <frame_constants.h>
+#include <generator.h>
+#include <gl_resources.h>
+#include <point_modes.h>
+#include <shader.h>
+
+#define WARMUP_FRAMES 1
+#define MEASURED_FRAMES 3
+
+/**
+ * The CPU rasterizer against the context's GL implementation (llvmpipe on machines
+ * without a GPU), drawing the same frame: in draw order as the program does, and
+ * with depth testing. Reports both frame times and the share of pixels whose
+ * color differs between the two images.
+ */
+void benchCpuRaster(BenchContext& context) {
+    const int counts[] = {100000, 1000000, 10000000};
+    const int width = context.width, height = context.height;
+
+    Framebuffer framebuffer;
+    Renderbuffer renderbuffers[2];
+    renderbuffers[0].storage(GL_RGBA8, width, height);
+    renderbuffers[1].storage(GL_DEPTH_COMPONENT24, width, height);
+    framebuffer.attach(GL_COLOR_ATTACHMENT0, renderbuffers[0]);
+    framebuffer.attach(GL_DEPTH_ATTACHMENT, renderbuffers[1]);
+    framebuffer.bind();
+    glViewport(0, 0, width, height);
+
+    Program shader(Shader((context.shaderDir / "vertex.glsl").string(),
+                          (context.shaderDir / "fragment.glsl").string()));
+    FrameConstantsBuffer frameConstantsBuffer;
+    FrameConstants frameConstants;
+    frameConstants.rotation = glm::rotate(glm::mat4(1.0f), 0.4f, glm::normalize(glm::vec3(-2, 3, 1)));
+    applyPointMode(POINT_MODE_DISCARD);
+    CpuRasterizer rasterizer(width, height);
+    std::vector<uint32_t> glPixels((size_t)width * height);
+
+    for (int count : counts) {
+        std::vector<vec3local> points(count);
+        populate3Darray(points.data(), count, 0.9f);
+        Buffer pointBuffer;
+        pointBuffer.storage(sizeof(vec3local) * count, points.data());
+        VertexArray vertexArray;
+        vertexArray.attribute(0, pointBuffer.ID, 3, GL_FLOAT, sizeof(vec3local));
+
+        for (bool depthTest : {false, true}) {
+            if (depthTest) {
+                GLState::enable(GL_DEPTH_TEST);
+            } else {
+                GLState::disable(GL_DEPTH_TEST);
+            }
+            rasterizer.depthTest = depthTest;
+
+            std::vector<double> glTimes, cpuTimes;
+            for (int frame = 0; frame < WARMUP_FRAMES + MEASURED_FRAMES; frame++) {
+                double start = nowSeconds();
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                frameConstantsBuffer.update(frameConstants);
+                shader.use();
+                vertexArray.bind();
+                glDrawArrays(GL_POINTS, 0, count);
+                glFinish();
+                double glFinished = nowSeconds();
+                rasterizer.render(points.data(), count, frameConstants);
+                double cpuFinished = nowSeconds();
+                if (frame >= WARMUP_FRAMES) {
+                    glTimes.push_back(glFinished - start);
+                    cpuTimes.push_back(cpuFinished - glFinished);
+                }
+            }
+
+            GLState::bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+            glPixelStorei(GL_PACK_ALIGNMENT, 4);
+            glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, glPixels.data());
+            size_t mismatched = 0;
+            for (size_t i = 0; i < glPixels.size(); i++) {
+                mismatched += glPixels[i] != rasterizer.pixels()[i];
+            }
+
+            std::string params = "N=" + std::to_string(count) + (depthTest ? " depth-test" : " draw-order");
+            context.results.push_back({"cpu_raster/gl_frame", params, median(glTimes) * 1e3, "ms"});
+            context.results.push_back({"cpu_raster/cpu_frame", params + (CpuRasterizer::simd() ? " avx2" : " scalar"),
+                                       median(cpuTimes) * 1e3, "ms"});
+            context.results.push_back({"cpu_raster/mismatch", params, 100.0 * mismatched / glPixels.size(), "%"});
+        }
+    }
+
+    GLState::disable(GL_DEPTH_TEST);
+    glBindFramebuffer(GL_FRAMEBUFFER, context.framebuffer);
+} /* benchCpuRaster() */
@@ -0,0 +1,68 @@
+#include "bench.h"
+
+#include <iostream>
+
+#include <glad.h>
+
+#include <frame_constants.h>
+#include <generator.h>
+#include <gl_resources.h>
+#include <gpu_culling.h>
+#include <instanced_renderer.h>
+#include <shader.h>
+
+#define BENCH_POINTS 2000
+#define WARMUP_FRAMES 10
+#define MEASURED_FRAMES 50
+
+/**
+ * GPU-culled multi-draw-indirect spheres, K from 1,000 to 100,000. Half of every
+ * grid is shifted out of the view so the cull pass has something to reject. As
+ * in benchInstanced(), CPU submission and whole-frame time are reported separately.
+ */
+void benchCulled(BenchContext& context) {
+    if (!CulledRenderer::supported()) {
+        std::cout << "culled: skipped, needs GL 4.3" << std::endl;
+        return;
+    }
+
+    std::vector<vec3local> points(BENCH_POINTS);
+    populate3Darray(points.data(), BENCH_POINTS, 0.9f);
+
+    Program shader(Shader((context.shaderDir / "instanced_vertex.glsl").string(),
+                          (context.shaderDir / "instanced_fragment.glsl").string()));
+    InstancedRenderer spheres(points.data(), BENCH_POINTS);
+    CulledRenderer culled(spheres, Shader::compute((context.shaderDir / "cull_compute.glsl").string()), 0.9f);
+    FrameConstantsBuffer frameConstantsBuffer;
+    FrameConstants frameConstants;
+    frameConstants.viewport = glm::vec4(context.width, context.height, 1.0f / context.width, 1.0f / context.height);
+
+    for (int count : {1000, 10000, 100000}) {
+        std::vector<SphereInstance> instances = InstancedRenderer::grid(count, BENCH_POINTS);
+        for (SphereInstance& instance : instances) {
+            instance.positionScale.x += 1.0f;
+        }
+        spheres.setInstances(instances.data(), count);
+
+        std::vector<double> submitTimes;
+        std::vector<double> frameTimes;
+        for (int frame = 0; frame < WARMUP_FRAMES + MEASURED_FRAMES; frame++) {
+            double start = nowSeconds();
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            frameConstantsBuffer.update(frameConstants);
+            culled.draw(shader);
+            double submitted = nowSeconds();
+            glFinish();
+            double finished = nowSeconds();
+
+            if (frame >= WARMUP_FRAMES) {
+                submitTimes.push_back(submitted - start);
+                frameTimes.push_back(finished - start);
+            }
+        }
+
+        std::string params = "K=" + std::to_string(count);
+        context.results.push_back({"culled/cpu_submit", params, median(submitTimes) * 1e6, "us"});
+        context.results.push_back({"culled/frame", params, median(frameTimes) * 1e3, "ms"});
+    }
+} /* benchCulled() */
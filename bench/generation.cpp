@@ -0,0 +1,38 @@
+#include "bench.h"
+
+#include <generator.h>
+
+#define MIN_POINTS_PER_SAMPLE 1000000
+#define SAMPLES 5
+
+/**
+ * Generation throughput of each point distribution, from 1k to 100M points. Small
+ * sizes repeat the generation until a sample covers a million points; the random
+ * distribution is seeded so every run generates the same points.
+ */
+void benchGeneration(BenchContext& context) {
+    const int counts[] = {1000, 10000, 100000, 1000000, 10000000, 100000000};
+    const char* distributions[] = {"spiral", "random"};
+
+    for (int count : counts) {
+        std::vector<vec3local> points(count);
+        int repeats = std::max(1, MIN_POINTS_PER_SAMPLE / count);
+        int samples = count >= 10000000 ? 1 : SAMPLES;
+        for (int distribution = 0; distribution < 2; distribution++) {
+            std::vector<double> times;
+            for (int sample = 0; sample < samples; sample++) {
+                double start = nowSeconds();
+                for (int repeat = 0; repeat < repeats; repeat++) {
+                    if (distribution == 0) {
+                        populate3Darray(points.data(), count, 0.9f);
+                    } else {
+                        populate3Drand(points.data(), count, 0.9f, 1);
+                    }
+                }
+                times.push_back((nowSeconds() - start) / repeats);
+            }
+            std::string params = std::string(distributions[distribution]) + " N=" + std::to_string(count);
+            context.results.push_back({"generation/throughput", params, count / median(times) * 1e-6, "Mpoints/s"});
+        }
+    }
+} /* benchGeneration() */
@@ -0,0 +1,79 @@
+#include "bench.h"
+
+#include <iostream>
+
+#include <glad.h>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <frame_constants.h>
+#include <depth_sort.h>
+#include <generator.h>
+#include <gl_resources.h>
+#include <gpu_sort.h>
+
+#define WARMUP_FRAMES 1
+#define MEASURED_FRAMES 5
+
+/**
+ * Per-frame depth sort of N points: depthSortCPU() against the compute-shader
+ * radix sort, which is checked against the CPU order first; any difference fails. The GPU time covers
+ * the sort only, from the first dispatch to glFinish.
+ */
+void benchGpuSort(BenchContext& context) {
+    if (!GpuDepthSorter::supported()) {
+        std::cout << "gpu_sort: skipped, needs GL 4.3" << std::endl;
+        return;
+    }
+
+    GpuDepthSorter sorter(context.shaderDir);
+    FrameConstantsBuffer frameConstantsBuffer;
+    FrameConstants frameConstants;
+    std::vector<uint32_t> indices;
+
+    for (int n : {100000, 1000000, 10000000}) {
+        std::vector<vec3local> points(n);
+        populate3Darray(points.data(), n, 0.9f);
+        Buffer pointBuffer;
+        pointBuffer.storage(sizeof(vec3local) * n, points.data());
+
+        std::vector<double> cpuTimes, gpuTimes;
+        int mismatches = -1;
+        for (int frame = 0; frame < WARMUP_FRAMES + MEASURED_FRAMES; frame++) {
+            frameConstants.rotation = glm::rotate(glm::mat4(1.0f), frame * 0.1f, glm::normalize(glm::vec3(-2, 3, 1)));
+            frameConstantsBuffer.update(frameConstants);
+
+            double start = nowSeconds();
+            depthSortCPU(points.data(), n, frameConstants.rotation, indices);
+            double cpuFinished = nowSeconds();
+            sorter.sort(pointBuffer.ID, n);
+            glFinish();
+            double gpuFinished = nowSeconds();
+
+            if (frame == 0) {
+                // both sorts are stable over identical keys, so the orders must match exactly
+                std::vector<uint32_t> gpuIndices(n);
+                GLState::bindBuffer(GL_SHADER_STORAGE_BUFFER, sorter.indexBuffer());
+                glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(uint32_t) * n, gpuIndices.data());
+                GLState::bindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+                mismatches = 0;
+                for (int i = 0; i < n; i++) {
+                    mismatches += gpuIndices[i] != indices[i];
+                }
+            }
+            if (frame >= WARMUP_FRAMES) {
+                cpuTimes.push_back(cpuFinished - start);
+                gpuTimes.push_back(gpuFinished - cpuFinished);
+            }
+        }
+
+        std::string params = "N=" + std::to_string(n);
+        context.results.push_back({"gpu_sort/cpu", params, median(cpuTimes) * 1e3, "ms"});
+        context.results.push_back({"gpu_sort/gpu", params, median(gpuTimes) * 1e3, "ms"});
+        context.results.push_back({"gpu_sort/mismatches", params, (double)mismatches, "indices"});
+        if (mismatches != 0) {
+            context.failures.push_back("gpu_sort: " + params + " differs from depthSortCPU() at "
+                                       + std::to_string(mismatches) + " indices");
+        }
+    }
+} /* benchGpuSort() */
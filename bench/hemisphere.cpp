@@ -0,0 +1,88 @@
+#include "bench.h"
+
+#include <glad.h>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <frame_constants.h>
+#include <generator.h>
+#include <gl_resources.h>
+#include <hemisphere_culling.h>
+#include <shader.h>
+
+#define WARMUP_FRAMES 3
+#define MEASURED_FRAMES 20
+
+/**
+ * Back-hemisphere culling at high N. Compares drawing every point, culling in the
+ * vertex shader only, and skipping far patches on the CPU first. Reports the
+ * fragments that reach the framebuffer (GL_SAMPLES_PASSED), the vertices
+ * submitted and the frame time.
+ */
+void benchHemisphere(BenchContext& context) {
+    for (int numPoints : {1000000, 4000000}) {
+        std::vector<vec3local> points(numPoints);
+        populate3Darray(points.data(), numPoints, 0.9f);
+        HemisphereCuller culler(points.data(), numPoints);
+
+        Buffer pointBuffer;
+        pointBuffer.storage(sizeof(vec3local) * numPoints, points.data());
+        VertexArray vertexArray;
+        vertexArray.attribute(0, pointBuffer.ID, 3, GL_FLOAT, sizeof(vec3local));
+
+        unsigned int query;
+        glGenQueries(1, &query);
+        FrameConstantsBuffer frameConstantsBuffer;
+        FrameConstants frameConstants;
+
+        const char* modes[] = {"off", "vertex", "patches+vertex"};
+        for (int mode = 0; mode < 3; mode++) {
+            Program shader(Shader((context.shaderDir / "vertex.glsl").string(),
+                                  (context.shaderDir / "fragment.glsl").string(),
+                                  {{3, "BACK_CULL_Z", mode == 0 ? -2.0f : 0.0f}}));
+            std::vector<GLint> firsts;
+            std::vector<GLsizei> counts;
+
+            std::vector<double> frameTimes;
+            double samples = 0.0, vertices = 0.0;
+            for (int frame = 0; frame < WARMUP_FRAMES + MEASURED_FRAMES; frame++) {
+                double start = nowSeconds();
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                frameConstants.rotation = glm::rotate(glm::mat4(1.0f), frame * 0.1f, glm::normalize(glm::vec3(-2, 3, 1)));
+                frameConstantsBuffer.update(frameConstants);
+                shader.use();
+                vertexArray.bind();
+                glBeginQuery(GL_SAMPLES_PASSED, query);
+                long submitted = numPoints;
+                if (mode == 2) {
+                    culler.visibleRanges(frameConstants.rotation, 0.0f, firsts, counts);
+                    glMultiDrawArrays(GL_POINTS, firsts.data(), counts.data(), (GLsizei)firsts.size());
+                    submitted = 0;
+                    for (GLsizei count : counts) {
+                        submitted += count;
+                    }
+                } else {
+                    glDrawArrays(GL_POINTS, 0, numPoints);
+                }
+                glEndQuery(GL_SAMPLES_PASSED);
+                glFinish();
+                double finished = nowSeconds();
+
+                if (frame >= WARMUP_FRAMES) {
+                    GLuint64 passed = 0;
+                    glGetQueryObjectui64v(query, GL_QUERY_RESULT, &passed);
+                    samples += (double)passed / MEASURED_FRAMES;
+                    vertices += (double)submitted / MEASURED_FRAMES;
+                    frameTimes.push_back(finished - start);
+                }
+            }
+
+            std::string params = "N=" + std::to_string(numPoints) + " cull=" + modes[mode];
+            context.results.push_back({"hemisphere/fragments", params, samples, "samples"});
+            context.results.push_back({"hemisphere/vertices", params, vertices, "vertices"});
+            context.results.push_back({"hemisphere/frame", params, median(frameTimes) * 1e3, "ms"});
+        }
+
+        glDeleteQueries(1, &query);
+    }
+} /* benchHemisphere() */
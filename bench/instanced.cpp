@@ -0,0 +1,62 @@
+#include "bench.h"
+
+#include <glad.h>
+
+#include <frame_constants.h>
+#include <generator.h>
+#include <gl_resources.h>
+#include <instanced_renderer.h>
+#include <shader.h>
+
+#define BENCH_POINTS 2000
+#define WARMUP_FRAMES 10
+#define MEASURED_FRAMES 100
+
+/**
+ * CPU cost of submitting one frame of K instanced spheres, for K from 1 to 10,000.
+ * Only the submission (constants update + draw call) is timed; glFinish() runs
+ * outside the timed region so GPU work does not leak into the CPU numbers. The
+ * instance buffer is uploaded once per K and timed separately.
+ */
+void benchInstanced(BenchContext& context) {
+    std::vector<vec3local> points(BENCH_POINTS);
+    populate3Darray(points.data(), BENCH_POINTS, 0.9f);
+
+    Program shader(Shader((context.shaderDir / "instanced_vertex.glsl").string(),
+                          (context.shaderDir / "instanced_fragment.glsl").string()));
+    InstancedRenderer spheres(points.data(), BENCH_POINTS);
+    FrameConstantsBuffer frameConstantsBuffer;
+    FrameConstants frameConstants;
+
+    for (int count : {1, 10, 100, 1000, 10000}) {
+        std::vector<SphereInstance> instances = InstancedRenderer::grid(count, BENCH_POINTS);
+
+        double uploadStart = nowSeconds();
+        spheres.setInstances(instances.data(), count);
+        glFinish();
+        double uploadTime = nowSeconds() - uploadStart;
+
+        std::vector<double> submitTimes;
+        std::vector<double> frameTimes;
+        for (int frame = 0; frame < WARMUP_FRAMES + MEASURED_FRAMES; frame++) {
+            double start = nowSeconds();
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            frameConstants.time.x = frame * 0.016f;
+            frameConstantsBuffer.update(frameConstants);
+            spheres.draw(shader);
+            double submitted = nowSeconds();
+            glFinish();
+            double finished = nowSeconds();
+
+            if (frame >= WARMUP_FRAMES) {
+                submitTimes.push_back(submitted - start);
+                frameTimes.push_back(finished - start);
+            }
+        }
+
+        std::string params = "K=" + std::to_string(count);
+        context.results.push_back({"instanced/cpu_submit", params, median(submitTimes) * 1e6, "us"});
+        context.results.push_back({"instanced/frame", params, median(frameTimes) * 1e3, "ms"});
+        context.results.push_back({"instanced/instance_upload", params, uploadTime * 1e3, "ms"});
+    }
+} /* benchInstanced() */
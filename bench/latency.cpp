@@ -0,0 +1,119 @@
+#include "bench.h"
+
+#include <cmath>
+
+#include <glad.h>
+
+#include <arcball.h>
+#include <point_sphere.h>
+
+#define INPUT_RATE 1000.0       // cursor events per second, as from a 1 kHz mouse
+#define REFRESH_RATE 60.0
+#define MEASURED_FRAMES 240
+
+/**
+ * The synthetic drag: the cursor traces a Lissajous figure around the center of
+ * the window, speeding up and slowing down and turning as a hand does
+ */
+static void cursorAt(double time, int width, int height, double& x, double& y) {
+    double radius = std::min(width, height) / 2.0;
+    x = width / 2.0 + 0.5 * radius * std::sin(2.0 * M_PI * 0.5 * time);
+    y = height / 2.0 + 0.4 * radius * std::sin(2.0 * M_PI * 0.35 * time);
+} /* cursorAt() */
+
+/**
+ * How far behind the cursor a dragged sphere is shown, measured with synthetic
+ * input on a simulated 60 Hz display. Cursor events arrive at INPUT_RATE; each
+ * frame really renders, and is shown at the first vsync after it finishes. The
+ * frame's orientation is compared with the one the drag reaches by that vsync.
+ *
+ * frame-start takes the drag when the frame starts, right after the previous vsync;
+ * late-latch waits for the DisplayClock's latch time; late-latch+predict also
+ * extrapolates the drag to the vsync. Reports the error in pixels on the sphere's
+ * rim, as mean and p95, the lag that error amounts to at the drag's speed, and the
+ * vsyncs missed.
+ */
+void benchLatency(BenchContext& context) {
+    const PointSphereConfig& config = context.sphere;
+    PointSphere sphere(config);
+    FrameInput input;
+    input.framebufferWidth = context.width;
+    input.framebufferHeight = context.height;
+    input.framebuffer = context.framebuffer;
+    const double pixelsPerRadian = config.scale * std::min(context.width, context.height) / 2.0;
+
+    struct Mode {
+        const char* name;
+        bool lateLatch, predict;
+    };
+    const Mode modes[] = {
+        {"frame-start", false, false},
+        {"late-latch", true, false},
+        {"late-latch+predict", true, true},
+    };
+    for (const Mode& mode : modes) {
+        // The arcball the frames take their input from and one fed up to each vsync
+        Arcball drag, truth;
+        long dragEvents = 0, truthEvents = 0;
+        auto feed = [&](Arcball& arcball, long& events, double until) {
+            for (; events / INPUT_RATE <= until; events++) {
+                double x, y;
+                cursorAt(events / INPUT_RATE, context.width, context.height, x, y);
+                if (events == 0) {
+                    arcball.resize(context.width, context.height);
+                    arcball.press(x, y, 0.0);
+                } else {
+                    arcball.drag(x, y, events / INPUT_RATE);
+                }
+            }
+        };
+
+        DisplayClock display(REFRESH_RATE);
+        double now = 1.0;       // a second into the drag
+        display.swapped(now, 0.0);
+        std::vector<double> errors, lags;
+        int missed = 0;
+        for (int frame = 0; frame < MEASURED_FRAMES; frame++) {
+            double vsync = display.nextVsync(now);
+            double latch = mode.lateLatch ? std::max(now, display.latchTime(vsync)) : now;
+            feed(drag, dragEvents, latch);
+            input.time = (float)vsync;
+            input.orientation = mode.predict ? drag.sample().predict(vsync) : drag.sample().orientation;
+
+            double start = nowSeconds();
+            sphere.render(input);
+            glFinish();
+            double renderSeconds = nowSeconds() - start;
+
+            double shown = vsync;
+            while (shown < latch + renderSeconds) {
+                shown += display.refreshInterval;
+            }
+            if (shown > vsync + 1e-9) {
+                missed++;
+            }
+            display.swapped(shown, renderSeconds);
+            now = shown;
+
+            feed(truth, truthEvents, shown);
+            float cosine = std::min(1.0f, std::abs(glm::dot(input.orientation, truth.sample().orientation)));
+            double error = 2.0 * std::acos(cosine);
+            errors.push_back(error * pixelsPerRadian);
+            double speed = glm::length(truth.sample().velocity);
+            if (speed > 0.1) {
+                lags.push_back(1000.0 * error / speed);
+            }
+        }
+
+        double mean = 0.0;
+        for (double error : errors) {
+            mean += error;
+        }
+        mean /= errors.size();
+        std::sort(errors.begin(), errors.end());
+        context.results.push_back({"latency/error", mode.name, mean, "px"});
+        context.results.push_back({"latency/error_p95", mode.name, errors[errors.size() * 95 / 100], "px"});
+        context.results.push_back({"latency/lag", mode.name, median(lags), "ms"});
+        context.results.push_back({"latency/missed", mode.name, (double)missed, "frames"});
+    }
+} /* benchLatency() */
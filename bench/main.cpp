@@ -0,0 +1,320 @@
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+#include <sys/utsname.h>
+
+#define GLFW_INCLUDE_NONE
+#include <glad.h>
+#include <GLFW/glfw3.h>
+
+#include <gl_state.h>
+#include <settings.h>
+#ifdef POINT_SPHERE_EGL
+#include <headless_context.h>
+#endif
+
+#include "bench.h"
+#include "revision.h"
+
+#define WIDTH 1024
+#define HEIGHT 1024
+
+#ifndef POINT_SPHERE_BUILD_TYPE
+#define POINT_SPHERE_BUILD_TYPE "unknown"
+#endif
+
+// A benchmark case, selected by name with --suite
+struct BenchCase {
+    const char* name;
+    void (*run)(BenchContext& context);
+};
+
+const BenchCase BENCH_CASES[] = {
+    {"generation", benchGeneration},
+    {"upload", benchUpload},
+    {"point_modes", benchPointModes},
+    {"instanced", benchInstanced},
+    {"culled", benchCulled},
+    {"hemisphere", benchHemisphere},
+    {"analytic_aa", benchAnalyticAA},
+    {"oit", benchOIT},
+    {"gpu_sort", benchGpuSort},
+    {"streaming", benchStreaming},
+    {"state", benchState},
+    {"readback", benchReadback},
+    {"cpu_raster", benchCpuRaster},
+    {"profiler", benchProfiler},
+    {"trace", benchTrace},
+    {"pacing", benchPacing},
+    {"latency", benchLatency},
+    {"rotation", benchRotation},
+    {"sphere", benchSphere},
+    {"oit_viewport", benchOITViewport},
+};
+
+/**
+ * Quotes a string for JSON
+ */
+std::string jsonString(const std::string& text) {
+    std::ostringstream out;
+    out << '"';
+    for (unsigned char c : text) {
+        if (c == '"' || c == '\\') {
+            out << '\\' << c;
+        } else if (c < 0x20) {
+            out << "\\u" << std::hex << std::setw(4) << std::setfill('0') << (int)c << std::dec;
+        } else {
+            out << c;
+        }
+    }
+    out << '"';
+    return out.str();
+} /* jsonString() */
+
+/**
+ * Reads the value of the first "key : value" line of a /proc file, or ""
+ */
+std::string procValue(const char* path, const std::string& key) {
+    std::ifstream file(path);
+    std::string line;
+    while (std::getline(file, line)) {
+        size_t colon = line.find(':');
+        if (colon != std::string::npos && line.compare(0, key.size(), key) == 0) {
+            size_t start = line.find_first_not_of(" \t", colon + 1);
+            return start == std::string::npos ? "" : line.substr(start);
+        }
+    }
+    return "";
+} /* procValue() */
+
+/**
+ * Describes the machine, the build and the GL implementation, so results from
+ * different runs can be told apart
+ */
+std::vector<std::pair<std::string, std::string>> systemInfo(bool headless) {
+    struct utsname host;
+    std::string os = uname(&host) == 0
+        ? std::string(host.sysname) + " " + host.release + " " + host.machine : "unknown";
+    char date[32];
+    std::time_t now = std::time(NULL);
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+    #if defined(__clang__)
+    std::string compiler = __VERSION__;
+    #elif defined(__GNUC__)
+    std::string compiler = "GCC " __VERSION__;
+    #else
+    std::string compiler = "unknown";
+    #endif
+
+    return {
+        {"date", date},
+        {"revision", POINT_SPHERE_REVISION},
+        {"build_type", POINT_SPHERE_BUILD_TYPE},
+        {"compiler", compiler},
+        {"os", os},
+        {"cpu", procValue("/proc/cpuinfo", "model name")},
+        {"hardware_threads", std::to_string(std::thread::hardware_concurrency())},
+        {"memory", procValue("/proc/meminfo", "MemTotal")},
+        {"context", headless ? "egl" : "glfw"},
+        {"gl_vendor", reinterpret_cast<const char*>(glGetString(GL_VENDOR))},
+        {"gl_renderer", reinterpret_cast<const char*>(glGetString(GL_RENDERER))},
+        {"gl_version", reinterpret_cast<const char*>(glGetString(GL_VERSION))},
+    };
+} /* systemInfo() */
+
+/**
+ * Writes the system info and every result as one JSON document
+ */
+bool writeJson(const std::string& path, const std::vector<std::pair<std::string, std::string>>& system,
+               const std::vector<BenchResult>& results) {
+    std::ofstream out(path);
+    if (!out) {
+        std::cerr << "ERROR::BENCH::CANNOT_WRITE " << path << std::endl;
+        return false;
+    }
+    out << "{\n  \"system\": {";
+    for (size_t i = 0; i < system.size(); i++) {
+        out << (i == 0 ? "\n" : ",\n") << "    " << jsonString(system[i].first) << ": " << jsonString(system[i].second);
+    }
+    out << "\n  },\n  \"results\": [";
+    out << std::setprecision(9);
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchResult& result = results[i];
+        out << (i == 0 ? "\n" : ",\n") << "    {\"name\": " << jsonString(result.name)
+            << ", \"params\": " << jsonString(result.params)
+            << ", \"value\": " << result.value
+            << ", \"unit\": " << jsonString(result.unit) << "}";
+    }
+    out << "\n  ]\n}\n";
+    return (bool)out;
+} /* writeJson() */
+
+/**
+ * Benchmark driver
+ * Creates a hidden window for the GL context, runs the benchmark cases and prints
+ * one line per measurement. Exits with 1 if a case's correctness check fails.
+ *
+ * Usage: point-sphere-bench [--headless] [--suite NAME[,NAME...]] [--json PATH] [--list]
+ *                           [--config PATH] [--NAME VALUE ...]
+ * --headless takes the context from EGL instead, so no display is needed.
+ * --suite runs only the named cases, in the given order; --list prints their names.
+ * --json also writes the results, with the system info, to PATH.
+ * --config and --NAME VALUE take point-sphere's settings; the cases that draw the
+ * whole sphere (sphere, pacing, latency) draw that one, at the bench's own size.
+ */
+
+int main(int argc, char* argv[]) {
+    bool headless = false;
+    std::string jsonPath, configPath;
+    std::vector<std::pair<std::string, std::string>> overrides;
+    std::vector<const BenchCase*> selected;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool valid = true;
+        if (arg == "--headless") {
+            headless = true;
+        } else if (arg == "--json" && i + 1 < argc) {
+            jsonPath = argv[++i];
+        } else if (arg == "--suite" && i + 1 < argc) {
+            std::stringstream names(argv[++i]);
+            std::string name;
+            while (valid && std::getline(names, name, ',')) {
+                auto found = std::find_if(std::begin(BENCH_CASES), std::end(BENCH_CASES),
+                                          [&name](const BenchCase& benchCase) { return name == benchCase.name; });
+                valid = found != std::end(BENCH_CASES);
+                if (valid) {
+                    selected.push_back(found);
+                } else {
+                    std::cerr << "Unknown benchmark case " << name << std::endl;
+                }
+            }
+        } else if (arg == "--list") {
+            for (const BenchCase& benchCase : BENCH_CASES) {
+                std::cout << benchCase.name << std::endl;
+            }
+            return 0;
+        } else if (arg == "--config" && i + 1 < argc) {
+            configPath = argv[++i];
+        } else if (arg.compare(0, 2, "--") == 0 && findSetting(arg.substr(2)) != NULL && i + 1 < argc) {
+            overrides.push_back({arg.substr(2), argv[++i]});
+        } else {
+            valid = false;
+        }
+        if (!valid) {
+            std::cerr << "Usage: " << argv[0] << " [--headless] [--suite NAME[,NAME...]] [--json PATH] [--list]"
+                      << " [--config PATH] [--NAME VALUE ...]" << std::endl;
+            return 1;
+        }
+    }
+    Settings settings;
+    if (!loadSettings(settings, configPath, overrides)) {
+        return 1;
+    }
+    if (selected.empty()) {
+        for (const BenchCase& benchCase : BENCH_CASES) {
+            selected.push_back(&benchCase);
+        }
+    }
+
+    BenchContext context;
+    context.framebuffer = 0;
+
+    #ifdef POINT_SPHERE_EGL
+    HeadlessContext * headlessContext = NULL;
+    #endif
+    if (headless) {
+        #ifdef POINT_SPHERE_EGL
+        headlessContext = new HeadlessContext(WIDTH, HEIGHT);
+        if (!headlessContext->valid() || !gladLoadGLLoader((GLADloadproc)HeadlessContext::getProcAddress)) {
+            std::cerr << "Failed to create a headless GL context" << std::endl;
+            return -1;
+        }
+        headlessContext->createFramebuffer();
+        context.framebuffer = headlessContext->framebuffer();
+        #else
+        std::cerr << "Headless benchmarks need a build with EGL" << std::endl;
+        return 1;
+        #endif
+    } else {
+        if (!glfwInit()) {
+            std::cerr << "Issue with inializing glfw" << std::endl;
+            return -1;
+        }
+
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+        GLFWwindow * window = glfwCreateWindow(WIDTH, HEIGHT, "point-sphere-bench", NULL, NULL);
+        if (window == NULL) {
+            glfwTerminate();
+            std::cerr << "Failed to create GLFW window" << std::endl;
+            return -1;
+        }
+        glfwMakeContextCurrent(window);
+        glfwSwapInterval(0);
+
+        if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+            std::cerr << "Failed to initialize GLAD" << std::endl;
+            glfwTerminate();
+            return -1;
+        }
+    }
+
+    glViewport(0, 0, WIDTH, HEIGHT);
+    GLState::enable(GL_PROGRAM_POINT_SIZE);
+
+    context.shaderDir = fs::absolute(argv[0]).parent_path() / "../src/shaders";
+    context.sphere = settings.sphere;
+    context.sphere.shaderDir = context.shaderDir;
+    const Settings defaults;
+    for (const SettingOption& option : settingOptions()) {
+        if (option.get(settings) != option.get(defaults)) {
+            context.sphereParams += (context.sphereParams.empty() ? "" : " ") + std::string(option.name) + "=" + option.get(settings);
+        }
+    }
+    context.width = WIDTH;
+    context.height = HEIGHT;
+
+    std::cout << "renderer: " << glGetString(GL_RENDERER) << std::endl;
+    std::vector<std::pair<std::string, std::string>> system = systemInfo(headless);
+
+    for (const BenchCase* benchCase : selected) {
+        benchCase->run(context);
+        // cases leave their own framebuffers and viewports behind
+        glBindFramebuffer(GL_FRAMEBUFFER, context.framebuffer);
+        glViewport(0, 0, WIDTH, HEIGHT);
+    }
+
+    for (const BenchResult& result : context.results) {
+        std::cout << std::left << std::setw(28) << result.name
+                  << std::setw(32) << result.params
+                  << std::right << std::setw(12) << std::fixed << std::setprecision(3) << result.value
+                  << " " << result.unit << std::endl;
+    }
+
+    int status = 0;
+    for (const std::string& failure : context.failures) {
+        std::cerr << "ERROR::BENCH::CHECK_FAILED " << failure << std::endl;
+        status = 1;
+    }
+    if (!jsonPath.empty() && !writeJson(jsonPath, system, context.results)) {
+        status = 1;
+    }
+
+    #ifdef POINT_SPHERE_EGL
+    if (headlessContext != NULL) {
+        headlessContext->terminate();
+        delete headlessContext;
+    }
+    #endif
+    if (!headless) {
+        glfwTerminate();
+    }
+    return status;
+} /* main() */
@@ -0,0 +1,138 @@
+#include "bench.h"
+
+#include <iostream>
+
+#include <glad.h>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <frame_constants.h>
+#include <depth_sort.h>
+#include <generator.h>
+#include <gl_resources.h>
+#include <oit.h>
+#include <point_modes.h>
+#include <shader.h>
+
+#define BENCH_POINTS 1000000
+#define BENCH_WIDTH 3840
+#define BENCH_HEIGHT 2160
+#define WARMUP_FRAMES 1
+#define MEASURED_FRAMES 5
+
+/**
+ * Translucent analytic points at 4K: plain blending in spiral order (wrong
+ * where points overlap), the per-frame CPU depth sort, weighted blended OIT and
+ * per-pixel linked lists. Extra memory beyond the RGBA8 target is reported next
+ * to frame time.
+ */
+void benchOIT(BenchContext& context) {
+    std::vector<vec3local> points(BENCH_POINTS);
+    populate3Darray(points.data(), BENCH_POINTS, 0.9f);
+
+    Buffer pointBuffer, indexBuffer;
+    pointBuffer.storage(sizeof(vec3local) * BENCH_POINTS, points.data());
+    VertexArray vertexArray;
+    vertexArray.attribute(0, pointBuffer.ID, 3, GL_FLOAT, sizeof(vec3local));
+    vertexArray.elementBuffer(indexBuffer.ID);
+
+    Framebuffer framebuffer;
+    Renderbuffer color;
+    color.storage(GL_RGBA8, BENCH_WIDTH, BENCH_HEIGHT);
+    framebuffer.attach(GL_COLOR_ATTACHMENT0, color);
+
+    FrameConstantsBuffer frameConstantsBuffer;
+    FrameConstants frameConstants;
+    frameConstants.viewport = glm::vec4(BENCH_WIDTH, BENCH_HEIGHT, 1.0f / BENCH_WIDTH, 1.0f / BENCH_HEIGHT);
+    frameConstants.backColor.a = 0.5f;
+    frameConstants.frontColor.a = 0.5f;
+    std::vector<uint32_t> indices;
+    const std::vector<ShaderConstant> constants = {{4, "POINT_MODE", (float)POINT_MODE_ANALYTIC}};
+
+    struct Variant {
+        const char* name;
+        TransparencyMode mode;
+        bool sorted;
+    };
+    const Variant variants[] = {
+        {"blend-unsorted", TRANSPARENCY_NONE, false},
+        {"blend-cpu-sorted", TRANSPARENCY_NONE, true},
+        {"weighted", TRANSPARENCY_WEIGHTED, false},
+        {"linked-list", TRANSPARENCY_LINKED_LIST, false},
+    };
+
+    Program blendShader(Shader((context.shaderDir / "vertex.glsl").string(),
+                               (context.shaderDir / "fragment.glsl").string(), constants));
+
+    for (const Variant& variant : variants) {
+        WeightedBlendedOIT * weighted = NULL;
+        LinkedListOIT * linkedList = NULL;
+        if (variant.mode == TRANSPARENCY_WEIGHTED) {
+            if (!WeightedBlendedOIT::supported()) {
+                std::cout << "oit: " << variant.name << " skipped, needs GL 4.0" << std::endl;
+                continue;
+            }
+            weighted = new WeightedBlendedOIT(context.shaderDir, constants);
+        } else if (variant.mode == TRANSPARENCY_LINKED_LIST) {
+            if (!LinkedListOIT::supported()) {
+                std::cout << "oit: " << variant.name << " skipped, needs GL 4.3" << std::endl;
+                continue;
+            }
+            linkedList = new LinkedListOIT(context.shaderDir, constants);
+        }
+
+        std::vector<double> frameTimes;
+        for (int frame = 0; frame < WARMUP_FRAMES + MEASURED_FRAMES; frame++) {
+            double start = nowSeconds();
+            framebuffer.bind();
+            glViewport(0, 0, BENCH_WIDTH, BENCH_HEIGHT);
+            glClear(GL_COLOR_BUFFER_BIT);
+            frameConstants.rotation = glm::rotate(glm::mat4(1.0f), frame * 0.1f, glm::normalize(glm::vec3(-2, 3, 1)));
+            frameConstantsBuffer.update(frameConstants);
+            if (weighted != NULL) {
+                weighted->begin(BENCH_WIDTH, BENCH_HEIGHT);
+            } else if (linkedList != NULL) {
+                linkedList->begin(BENCH_WIDTH, BENCH_HEIGHT);
+            } else {
+                applyPointMode(POINT_MODE_ANALYTIC);
+                blendShader.use();
+            }
+            vertexArray.bind();
+            if (variant.sorted) {
+                depthSortCPU(points.data(), BENCH_POINTS, frameConstants.rotation, indices);
+                indexBuffer.data(sizeof(uint32_t) * BENCH_POINTS, indices.data(), GL_STREAM_DRAW);
+                glDrawElements(GL_POINTS, BENCH_POINTS, GL_UNSIGNED_INT, NULL);
+            } else {
+                glDrawArrays(GL_POINTS, 0, BENCH_POINTS);
+            }
+            if (weighted != NULL) {
+                weighted->end(framebuffer.ID, 0, 0);
+            } else if (linkedList != NULL) {
+                linkedList->end(framebuffer.ID, 0, 0);
+            } else {
+                applyPointMode(POINT_MODE_DISCARD);
+            }
+            glFinish();
+            double finished = nowSeconds();
+            if (frame >= WARMUP_FRAMES) {
+                frameTimes.push_back(finished - start);
+            }
+        }
+
+        size_t memory = 0;
+        if (weighted != NULL) {
+            memory = weighted->memoryUsage();
+            delete weighted;
+        } else if (linkedList != NULL) {
+            memory = linkedList->memoryUsage();
+            delete linkedList;
+        }
+
+        std::string params = std::string("4K N=1M ") + variant.name;
+        context.results.push_back({"oit/frame", params, median(frameTimes) * 1e3, "ms"});
+        context.results.push_back({"oit/extra_memory", params, memory / (1024.0 * 1024.0), "MiB"});
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, context.framebuffer);
+    glViewport(0, 0, context.width, context.height);
+} /* benchOIT() */
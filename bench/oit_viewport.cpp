@@ -0,0 +1,75 @@
+#include "bench.h"
+
+#include <iostream>
+
+#include <glad.h>
+
+#include <gl_resources.h>
+#include <oit.h>
+#include <point_modes.h>
+#include <point_sphere.h>
+
+#define CHECK_WIDTH 440
+#define CHECK_HEIGHT 405
+
+/**
+ * The OIT paths on a framebuffer that is not square, where the sphere's viewport
+ * is offset: each must put the sphere where plain blending does. Reports the left
+ * and right edge of the drawn pixels per mode and fails if they differ.
+ */
+void benchOITViewport(BenchContext& context) {
+    Framebuffer framebuffer;
+    Renderbuffer renderbuffers[2];
+    renderbuffers[0].storage(GL_RGBA8, CHECK_WIDTH, CHECK_HEIGHT);
+    renderbuffers[1].storage(GL_DEPTH_COMPONENT24, CHECK_WIDTH, CHECK_HEIGHT);
+    framebuffer.attach(GL_COLOR_ATTACHMENT0, renderbuffers[0]);
+    framebuffer.attach(GL_DEPTH_ATTACHMENT, renderbuffers[1]);
+
+    FrameInput input;
+    input.framebufferWidth = CHECK_WIDTH;
+    input.framebufferHeight = CHECK_HEIGHT;
+    input.framebuffer = framebuffer.ID;
+
+    std::vector<unsigned char> pixels((size_t)CHECK_WIDTH * CHECK_HEIGHT * 4);
+    int expectedLeft = -1, expectedRight = -1;
+    for (TransparencyMode mode : {TRANSPARENCY_NONE, TRANSPARENCY_WEIGHTED, TRANSPARENCY_LINKED_LIST}) {
+        if (mode == TRANSPARENCY_LINKED_LIST && !LinkedListOIT::supported()) {
+            std::cout << "oit_viewport: linked-list skipped, needs GL 4.3" << std::endl;
+            continue;
+        }
+        PointSphereConfig config = context.sphere;
+        config.pointMode = POINT_MODE_ANALYTIC;
+        config.transparencyMode = mode;
+        {
+            PointSphere sphere(config);
+            sphere.render(input);
+        }
+        framebuffer.bind();
+        glReadPixels(0, 0, CHECK_WIDTH, CHECK_HEIGHT, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+
+        // the corner is background; any other color is the sphere
+        int left = CHECK_WIDTH, right = -1;
+        for (int y = 0; y < CHECK_HEIGHT; y++) {
+            for (int x = 0; x < CHECK_WIDTH; x++) {
+                const unsigned char* pixel = &pixels[((size_t)y * CHECK_WIDTH + x) * 4];
+                if (pixel[0] != pixels[0] || pixel[1] != pixels[1] || pixel[2] != pixels[2]) {
+                    left = std::min(left, x);
+                    right = std::max(right, x);
+                }
+            }
+        }
+        const char* name = transparencyModeName(mode);
+        context.results.push_back({"oit_viewport/left", name, (double)left, "px"});
+        context.results.push_back({"oit_viewport/right", name, (double)right, "px"});
+        if (mode == TRANSPARENCY_NONE) {
+            expectedLeft = left;
+            expectedRight = right;
+        } else if (std::abs(left - expectedLeft) > 1 || std::abs(right - expectedRight) > 1) {
+            context.failures.push_back(std::string("oit_viewport: ") + name + " draws x " + std::to_string(left) + "-"
+                                       + std::to_string(right) + " instead of " + std::to_string(expectedLeft) + "-"
+                                       + std::to_string(expectedRight));
+        }
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+} /* benchOITViewport() */
@@ -0,0 +1,83 @@
+#include "bench.h"
+
+#include <ctime>
+#include <fstream>
+#include <thread>
+
+#include <glad.h>
+
+#include <frame_pacer.h>
+#include <point_sphere.h>
+
+#define RUN_SECONDS 3.0
+#define RAPL_ENERGY "/sys/class/powercap/intel-rapl:0/energy_uj"
+
+/**
+ * Reads the CPU package's energy counter in joules, or -1 where RAPL is not exposed
+ */
+static double packageJoules() {
+    std::ifstream counter(RAPL_ENERGY);
+    double microjoules = -1.0;
+    if (!(counter >> microjoules)) {
+        return -1.0;
+    }
+    return microjoules * 1e-6;
+} /* packageJoules() */
+
+/**
+ * What frame pacing saves on the configured sphere rotating in real time, as on a
+ * kiosk: drawing as fast as possible, at 60 fps (a vsync-bound loop) and paced
+ * to changes of a few pixel thresholds at up to 60 fps. Each loop runs for RUN_SECONDS and
+ * reports its frame rate and the process CPU time per second, which on llvmpipe
+ * includes the rendering; package energy is added where RAPL is readable.
+ */
+void benchPacing(BenchContext& context) {
+    PointSphere sphere(context.sphere);
+    FrameInput input;
+    input.framebufferWidth = context.width;
+    input.framebufferHeight = context.height;
+    input.framebuffer = context.framebuffer;
+    const float pixelsPerSecond = sphere.pixelsPerSecond(std::min(context.width, context.height));
+
+    struct Mode {
+        const char* name;
+        double targetFps, pixelThreshold;
+    };
+    const Mode modes[] = {
+        {"unlimited", 0.0, 0.0},
+        {"60fps", 60.0, 0.0},
+        {"paced-0.5px", 60.0, 0.5},
+        {"paced-1px", 60.0, 1.0},
+        {"paced-2px", 60.0, 2.0},
+    };
+    std::vector<double> cpuShares;
+    for (const Mode& mode : modes) {
+        FramePacer pacer(mode.targetFps, mode.pixelThreshold);
+        double joules = packageJoules();
+        std::clock_t cpuStart = std::clock();
+        double start = nowSeconds(), now;
+        while ((now = nowSeconds() - start) < RUN_SECONDS) {
+            double delay = pacer.delay(now, pixelsPerSecond);
+            if (delay > 0.0) {
+                std::this_thread::sleep_for(std::chrono::duration<double>(delay));
+                continue;
+            }
+            input.time = (float)now;
+            sphere.render(input);
+            glFinish();
+            pacer.frameDrawn(now);
+        }
+        double cpu = (double)(std::clock() - cpuStart) / CLOCKS_PER_SEC / now;
+        cpuShares.push_back(cpu);
+
+        context.results.push_back({"pacing/fps", mode.name, pacer.framesDrawn() / now, "fps"});
+        context.results.push_back({"pacing/cpu", mode.name, 100.0 * cpu, "% core"});
+        if (joules >= 0.0) {
+            context.results.push_back({"pacing/power", mode.name, (packageJoules() - joules) / now, "W"});
+        }
+    }
+    for (size_t i = 2; i < cpuShares.size(); i++) {
+        context.results.push_back({"pacing/cpu_saved", std::string(modes[i].name) + " vs 60fps",
+                                   100.0 * (1.0 - cpuShares[i] / cpuShares[1]), "%"});
+    }
+} /* benchPacing() */
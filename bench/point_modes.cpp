@@ -0,0 +1,95 @@
+#include "bench.h"
+
+#include <glad.h>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <frame_constants.h>
+#include <generator.h>
+#include <gl_resources.h>
+#include <point_modes.h>
+#include <shader.h>
+
+#define BENCH_POINTS 10000000
+#define WARMUP_FRAMES 1
+#define MEASURED_FRAMES 3
+
+/**
+ * Fill rate of each round-point technique at 10M points. Every mode renders into
+ * its own offscreen framebuffer with depth testing on, so the cost of losing early
+ * depth testing in the discard modes shows up; alpha-to-coverage gets 4x MSAA.
+ */
+void benchPointModes(BenchContext& context) {
+    std::vector<vec3local> points(BENCH_POINTS);
+    populate3Darray(points.data(), BENCH_POINTS, 0.9f);
+
+    Buffer pointBuffer;
+    pointBuffer.storage(sizeof(vec3local) * BENCH_POINTS, points.data());
+    VertexArray vertexArray;
+    vertexArray.attribute(0, pointBuffer.ID, 3, GL_FLOAT, sizeof(vec3local));
+    points.clear();
+    points.shrink_to_fit();
+
+    unsigned int query;
+    glGenQueries(1, &query);
+    FrameConstantsBuffer frameConstantsBuffer;
+    FrameConstants frameConstants;
+    GLState::enable(GL_DEPTH_TEST);
+
+    for (int m = 0; m < POINT_MODE_COUNT; m++) {
+        PointMode mode = (PointMode)m;
+        int samples = pointModeNeedsMultisample(mode) ? 4 : 0;
+
+        Framebuffer framebuffer;
+        Renderbuffer renderbuffers[2];
+        renderbuffers[0].storage(GL_RGBA8, context.width, context.height, samples);
+        renderbuffers[1].storage(GL_DEPTH_COMPONENT24, context.width, context.height, samples);
+        framebuffer.attach(GL_COLOR_ATTACHMENT0, renderbuffers[0]);
+        framebuffer.attach(GL_DEPTH_ATTACHMENT, renderbuffers[1]);
+        framebuffer.bind();
+
+        Program shader(Shader((context.shaderDir / "vertex.glsl").string(),
+                              (context.shaderDir / "fragment.glsl").string(),
+                              {{4, "POINT_MODE", (float)mode}}));
+
+        std::vector<double> frameTimes;
+        double fragments = 0.0;
+        for (int frame = 0; frame < WARMUP_FRAMES + MEASURED_FRAMES; frame++) {
+            double start = nowSeconds();
+            // The depth write mask applies to clears too, and the blending modes turn it off
+            GLState::depthMask(GL_TRUE);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            applyPointMode(mode);
+            frameConstants.rotation = glm::rotate(glm::mat4(1.0f), frame * 0.1f, glm::normalize(glm::vec3(-2, 3, 1)));
+            frameConstantsBuffer.update(frameConstants);
+            shader.use();
+            vertexArray.bind();
+            glBeginQuery(GL_SAMPLES_PASSED, query);
+            glDrawArrays(GL_POINTS, 0, BENCH_POINTS);
+            glEndQuery(GL_SAMPLES_PASSED);
+            glFinish();
+            double finished = nowSeconds();
+
+            if (frame >= WARMUP_FRAMES) {
+                GLuint64 passed = 0;
+                glGetQueryObjectui64v(query, GL_QUERY_RESULT, &passed);
+                fragments += (double)passed / MEASURED_FRAMES;
+                frameTimes.push_back(finished - start);
+            }
+        }
+        applyPointMode(POINT_MODE_DISCARD);
+        glBindFramebuffer(GL_FRAMEBUFFER, context.framebuffer);
+
+        double frameTime = median(frameTimes);
+        std::string params = std::string("N=10M mode=") + pointModeName(mode);
+        context.results.push_back({"point_modes/frame", params, frameTime * 1e3, "ms"});
+        context.results.push_back({"point_modes/throughput", params, BENCH_POINTS / frameTime / 1e6, "Mpoints/s"});
+        context.results.push_back({"point_modes/samples_passed", params, fragments, "samples"});
+        if (fragments == 0.0) {
+            context.failures.push_back("point_modes: " + params + " draws no samples");
+        }
+    }
+
+    GLState::disable(GL_DEPTH_TEST);
+    glDeleteQueries(1, &query);
+} /* benchPointModes() */
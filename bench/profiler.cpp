@@ -0,0 +1,35 @@
+#include "bench.h"
+
+#include <glad.h>
+
+#include <profiler.h>
+
+#define FRAMES 1000
+#define SCOPES_PER_FRAME 100
+
+/**
+ * Cost of the profiler when it is built in: entering and leaving a nested CPU
+ * scope, and a GPU scope around an empty stretch of commands (two timer queries).
+ * Without POINT_SPHERE_PROFILE the macros compile to nothing, so there is no
+ * disabled case to measure.
+ */
+void benchProfiler(BenchContext& context) {
+    for (bool gpu : {false, true}) {
+        double start = nowSeconds();
+        for (int frame = 0; frame < FRAMES; frame++) {
+            Profiler::beginFrame();
+            {
+                // endFrame() adds up the scopes closed so far, so outer has to close first
+                ProfileScope outer("outer");
+                for (int i = 0; i < SCOPES_PER_FRAME; i++) {
+                    ProfileScope inner("inner", gpu);
+                }
+            }
+            Profiler::endFrame();
+        }
+        glFinish();
+        double perScope = (nowSeconds() - start) / (FRAMES * (SCOPES_PER_FRAME + 1));
+        context.results.push_back({"profiler/scope", gpu ? "gpu" : "cpu", perScope * 1e9, "ns"});
+    }
+    Profiler::terminate();
+} /* benchProfiler() */
@@ -0,0 +1,107 @@
+#include "bench.h"
+
+#include <glad.h>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <frame_constants.h>
+#include <frame_encoder.h>
+#include <frame_readback.h>
+#include <generator.h>
+#include <gl_resources.h>
+#include <shader.h>
+
+#define BENCH_POINTS 100000
+#define BENCH_WIDTH 1920
+#define BENCH_HEIGHT 1080
+#define WARMUP_FRAMES 5
+#define MEASURED_FRAMES 60
+
+/**
+ * Reading every 1080p frame back for export: no readback, glReadPixels into
+ * client memory (waits for the frame), the pixel buffer ring, and the ring
+ * feeding the Y4M encoder thread (written to a temporary file). Reports the time per
+ * frame over the whole run, including the frames still in flight at the end.
+ */
+void benchReadback(BenchContext& context) {
+    std::vector<vec3local> points(BENCH_POINTS);
+    populate3Darray(points.data(), BENCH_POINTS, 0.9f);
+    Buffer pointBuffer;
+    pointBuffer.storage(sizeof(vec3local) * BENCH_POINTS, points.data());
+    VertexArray vertexArray;
+    vertexArray.attribute(0, pointBuffer.ID, 3, GL_FLOAT, sizeof(vec3local));
+    Program shader(Shader((context.shaderDir / "vertex.glsl").string(),
+                          (context.shaderDir / "fragment.glsl").string()));
+
+    Framebuffer framebuffer;
+    Renderbuffer color;
+    color.storage(GL_RGBA8, BENCH_WIDTH, BENCH_HEIGHT);
+    framebuffer.attach(GL_COLOR_ATTACHMENT0, color);
+    framebuffer.bind();
+    glViewport(0, 0, BENCH_WIDTH, BENCH_HEIGHT);
+
+    FrameConstantsBuffer frameConstantsBuffer;
+    FrameConstants frameConstants;
+    frameConstants.viewport = glm::vec4(BENCH_WIDTH, BENCH_HEIGHT, 1.0f / BENCH_WIDTH, 1.0f / BENCH_HEIGHT);
+
+    enum Method { NONE, SYNC, RING, RING_Y4M };
+    const std::pair<Method, const char*> methods[] = {
+        {NONE, "none"},
+        {SYNC, "glReadPixels"},
+        {RING, "pbo-ring"},
+        {RING_Y4M, "pbo-ring+y4m"},
+    };
+    const fs::path videoPath = fs::temp_directory_path() / "point-sphere-bench.y4m";
+    std::vector<unsigned char> pixels((size_t)BENCH_WIDTH * BENCH_HEIGHT * 4);
+    unsigned long checksum = 0;
+
+    for (const auto& [method, name] : methods) {
+        FrameReadback readback(BENCH_WIDTH, BENCH_HEIGHT);
+        FrameEncoder * encoder = method == RING_Y4M ? new FrameEncoder(videoPath.string(), BENCH_WIDTH, BENCH_HEIGHT) : NULL;
+        FrameReadback::Sink sink = [&](const unsigned char* rgba) {
+            if (encoder != NULL) {
+                encoder->submit(rgba);
+            } else {
+                checksum += rgba[0];
+            }
+        };
+
+        double start = 0.0;
+        for (int frame = 0; frame < WARMUP_FRAMES + MEASURED_FRAMES; frame++) {
+            if (frame == WARMUP_FRAMES) {
+                glFinish();
+                start = nowSeconds();
+            }
+            glClear(GL_COLOR_BUFFER_BIT);
+            frameConstants.rotation = glm::rotate(glm::mat4(1.0f), frame * 0.05f, glm::normalize(glm::vec3(-2, 3, 1)));
+            frameConstantsBuffer.update(frameConstants);
+            shader.use();
+            vertexArray.bind();
+            glDrawArrays(GL_POINTS, 0, BENCH_POINTS);
+
+            if (method == SYNC) {
+                glPixelStorei(GL_PACK_ALIGNMENT, 4);
+                glReadPixels(0, 0, BENCH_WIDTH, BENCH_HEIGHT, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+                checksum += pixels[0];
+            } else if (method != NONE) {
+                readback.capture(framebuffer.ID, sink);
+            }
+            glFlush();
+        }
+        readback.flush(sink);
+        if (encoder != NULL) {
+            encoder->finish();
+            delete encoder;
+            fs::remove(videoPath);
+        }
+        glFinish();
+        double frameTime = (nowSeconds() - start) / MEASURED_FRAMES;
+
+        std::string params = std::string("1080p ") + name;
+        context.results.push_back({"readback/frame", params, frameTime * 1e3, "ms"});
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, context.framebuffer);
+    glViewport(0, 0, context.width, context.height);
+    (void)checksum;
+} /* benchReadback() */
@@ -0,0 +1,25 @@
+# Writes OUTPUT with the source revision from git describe, or FALLBACK outside a
+# git checkout. Run with cmake -P on every build; the header is only rewritten when
+# the revision changed, so the bench is not recompiled otherwise.
+set(REVISION "")
+if(GIT_EXECUTABLE)
+    execute_process(
+        COMMAND ${GIT_EXECUTABLE} describe --always --dirty
+        WORKING_DIRECTORY ${SOURCE_DIR}
+        OUTPUT_VARIABLE REVISION
+        OUTPUT_STRIP_TRAILING_WHITESPACE
+        ERROR_QUIET
+    )
+endif()
+if(NOT REVISION)
+    set(REVISION ${FALLBACK})
+endif()
+
+set(CONTENT "#define POINT_SPHERE_REVISION \"${REVISION}\"\n")
+set(PREVIOUS "")
+if(EXISTS ${OUTPUT})
+    file(READ ${OUTPUT} PREVIOUS)
+endif()
+if(NOT CONTENT STREQUAL PREVIOUS)
+    file(WRITE ${OUTPUT} "${CONTENT}")
+endif()
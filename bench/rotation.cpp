@@ -0,0 +1,116 @@
+#include "bench.h"
+
+#include <cmath>
+#include <random>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <rotation_state.h>
+
+#define SINGLE_ITERATIONS 1000000
+#define BATCH_FRAMES 200
+#define DRIFT_FRAMES 3600
+
+/**
+ * A batch of count orientations with random axes, turning at up to 2 radians a second
+ */
+static RotationBatch randomBatch(int count) {
+    RotationBatch batch;
+    std::mt19937 gen(1);
+    std::normal_distribution<float> normal(0.0f, 1.0f);
+    std::uniform_real_distribution<float> speed(0.0f, 2.0f);
+    for (int i = 0; i < count; i++) {
+        glm::quat orientation = glm::normalize(glm::quat(normal(gen), normal(gen), normal(gen), normal(gen)));
+        glm::vec3 axis = glm::normalize(glm::vec3(normal(gen), normal(gen), normal(gen)));
+        batch.add(orientation, axis * speed(gen));
+    }
+    return batch;
+} /* randomBatch() */
+
+/**
+ * The angle of the rotation from b to a, from the vector part, which stays precise for small angles
+ */
+static float angleBetween(const glm::quat& a, const glm::quat& b) {
+    glm::quat difference = a * glm::conjugate(b);
+    return 2.0f * std::asin(std::min(1.0f, glm::length(glm::vec3(difference.x, difference.y, difference.z))));
+} /* angleBetween() */
+
+/**
+ * The sphere's rotation rebuilt from the total time each frame (glm::rotate) and
+ * advanced from the last frame (RotationState), in ns per frame. Then batches of
+ * K orientations, as the spinning instanced grid updates every frame, on the scalar
+ * and the AVX2 path in ns per orientation, and how far the batch's first-order
+ * steps drift from the exact rotation over a minute at 60 fps.
+ */
+void benchRotation(BenchContext& context) {
+    const glm::vec3 axis(-2.0f, 3.0f, 1.0f);
+    volatile float sink = 0.0f;
+
+    double start = nowSeconds();
+    for (int frame = 0; frame < SINGLE_ITERATIONS; frame++) {
+        glm::mat4 rotation = glm::rotate(glm::mat4(1.0f), frame / 60.0f * 0.07f, glm::normalize(axis));
+        sink = sink + rotation[0][0];
+    }
+    double scratch = (nowSeconds() - start) / SINGLE_ITERATIONS;
+
+    RotationState state(glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::normalize(axis) * 0.07f);
+    start = nowSeconds();
+    for (int frame = 0; frame < SINGLE_ITERATIONS; frame++) {
+        state.integrate(1.0f / 60.0f);
+        glm::mat4 rotation(state.matrix());
+        sink = sink + rotation[0][0];
+    }
+    double incremental = (nowSeconds() - start) / SINGLE_ITERATIONS;
+    context.results.push_back({"rotation/single", "glm::rotate", scratch * 1e9, "ns"});
+    context.results.push_back({"rotation/single", "RotationState", incremental * 1e9, "ns"});
+
+    for (int count : {1000, 10000, 100000}) {
+        std::string params = "K=" + std::to_string(count);
+        double perPath[2] = {0.0, 0.0};
+        RotationBatch results[2] = {randomBatch(count), randomBatch(count)};
+        for (int vectorized = 0; vectorized < 2; vectorized++) {
+            if (vectorized && !RotationBatch::simd()) {
+                continue;
+            }
+            std::vector<double> times;
+            for (int frame = 0; frame < BATCH_FRAMES; frame++) {
+                double frameStart = nowSeconds();
+                results[vectorized].integrate(1.0f / 60.0f, vectorized);
+                times.push_back(nowSeconds() - frameStart);
+            }
+            perPath[vectorized] = median(times) / count;
+            context.results.push_back({"rotation/batch", params + (vectorized ? " avx2" : " scalar"), perPath[vectorized] * 1e9, "ns"});
+        }
+        if (perPath[1] > 0.0) {
+            // the paths run the same float operations, so this should be 0
+            float difference = 0.0f;
+            for (int i = 0; i < count; i++) {
+                glm::quat a = results[0].orientation(i), b = results[1].orientation(i);
+                difference = std::max(difference, std::max(std::max(std::fabs(a.x - b.x), std::fabs(a.y - b.y)),
+                                                            std::max(std::fabs(a.z - b.z), std::fabs(a.w - b.w))));
+            }
+            context.results.push_back({"rotation/batch_speedup", params, perPath[0] / perPath[1], "x"});
+            context.results.push_back({"rotation/batch_paths_differ", params, difference, "max abs"});
+        }
+    }
+
+    // Drift of the first-order steps against exact RotationStates
+    const int driftCount = 1000;
+    RotationBatch batch = randomBatch(driftCount);
+    std::vector<RotationState> exact;
+    for (int i = 0; i < driftCount; i++) {
+        exact.push_back(RotationState(batch.orientation(i), batch.angularVelocity(i)));
+    }
+    for (int frame = 0; frame < DRIFT_FRAMES; frame++) {
+        batch.integrate(1.0f / 60.0f);
+        for (RotationState& state : exact) {
+            state.integrate(1.0f / 60.0f);
+        }
+    }
+    float drift = 0.0f;
+    for (int i = 0; i < driftCount; i++) {
+        drift = std::max(drift, angleBetween(batch.orientation(i), exact[i].orientation()));
+    }
+    context.results.push_back({"rotation/batch_drift", "60 s at 60 fps", glm::degrees(drift), "deg"});
+    (void)sink;
+} /* benchRotation() */
@@ -0,0 +1,39 @@
+#include "bench.h"
+
+#include <glad.h>
+
+#include <point_sphere.h>
+
+#define WARMUP_FRAMES 10
+#define MEASURED_FRAMES 100
+
+/**
+ * The whole sphere as point-sphere draws it, with the settings given to the bench,
+ * so a sweep over settings files or --NAME VALUE arguments measures each without a
+ * rebuild. Reports the median frame time, finished with glFinish, and the points
+ * drawn per second; the params name the settings that differ from the defaults.
+ */
+void benchSphere(BenchContext& context) {
+    PointSphere sphere(context.sphere);
+    FrameInput input;
+    input.framebufferWidth = context.width;
+    input.framebufferHeight = context.height;
+    input.framebuffer = context.framebuffer;
+
+    std::vector<double> times;
+    for (int frame = 0; frame < WARMUP_FRAMES + MEASURED_FRAMES; frame++) {
+        input.time = frame / 60.0f;
+        double start = nowSeconds();
+        sphere.render(input);
+        glFinish();
+        if (frame >= WARMUP_FRAMES) {
+            times.push_back(nowSeconds() - start);
+        }
+    }
+
+    std::string params = context.sphereParams.empty() ? "defaults" : context.sphereParams;
+    double frameTime = median(times);
+    double points = (double)context.sphere.numPoints * std::max(1, context.sphere.numSpheres);
+    context.results.push_back({"sphere/frame", params, frameTime * 1e3, "ms"});
+    context.results.push_back({"sphere/throughput", params, points / frameTime * 1e-6, "Mpoints/s"});
+} /* benchSphere() */
@@ -0,0 +1,78 @@
+#include "bench.h"
+
+#include <glad.h>
+
+#include <frame_constants.h>
+#include <generator.h>
+#include <gl_resources.h>
+#include <gl_state.h>
+#include <point_modes.h>
+#include <shader.h>
+
+#define BATCHES 2000
+#define BATCH_POINTS 64
+#define WARMUP_FRAMES 5
+#define MEASURED_FRAMES 50
+
+/**
+ * CPU cost of state changes. Every frame draws BATCHES small batches, each with
+ * one of two programs, two vertex arrays and two point modes (blended or not).
+ * Interleaved order changes all of them between draws; sorted order groups the
+ * batches by state, so the tracker elides most changes. Reports the state calls
+ * issued and elided per frame and the CPU time to submit a frame.
+ */
+void benchState(BenchContext& context) {
+    std::vector<vec3local> points(BATCH_POINTS * BATCHES);
+    populate3Darray(points.data(), (int)points.size(), 0.9f);
+    Buffer pointBuffer;
+    pointBuffer.storage(sizeof(vec3local) * points.size(), points.data());
+
+    VertexArray vertexArrays[2];
+    for (VertexArray& vertexArray : vertexArrays) {
+        vertexArray.attribute(0, pointBuffer.ID, 3, GL_FLOAT, sizeof(vec3local));
+    }
+    const PointMode modes[2] = {POINT_MODE_DISCARD, POINT_MODE_ANALYTIC};
+    Program programs[2] = {
+        Program(Shader((context.shaderDir / "vertex.glsl").string(), (context.shaderDir / "fragment.glsl").string(),
+                       {{4, "POINT_MODE", (float)modes[0]}})),
+        Program(Shader((context.shaderDir / "vertex.glsl").string(), (context.shaderDir / "fragment.glsl").string(),
+                       {{4, "POINT_MODE", (float)modes[1]}})),
+    };
+    FrameConstantsBuffer frameConstantsBuffer;
+    FrameConstants frameConstants;
+
+    // a small target keeps rasterization from hiding the submission cost
+    glViewport(0, 0, 64, 64);
+    for (bool sorted : {false, true}) {
+        std::vector<double> frameTimes;
+        GLStateCounters perFrame;
+        for (int frame = 0; frame < WARMUP_FRAMES + MEASURED_FRAMES; frame++) {
+            glFinish();
+            GLState::resetCounters();
+            double start = nowSeconds();
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            frameConstantsBuffer.update(frameConstants);
+            for (int batch = 0; batch < BATCHES; batch++) {
+                int program = sorted ? batch / (BATCHES / 2) : batch % 2;
+                int vertexArray = sorted ? (batch / (BATCHES / 4)) % 2 : (batch / 2) % 2;
+                applyPointMode(modes[program]);
+                programs[program].use();
+                vertexArrays[vertexArray].bind();
+                glDrawArrays(GL_POINTS, batch * BATCH_POINTS, BATCH_POINTS);
+            }
+            glFlush();
+            if (frame >= WARMUP_FRAMES) {
+                frameTimes.push_back(nowSeconds() - start);
+                perFrame = GLState::counters();
+            }
+        }
+
+        std::string params = std::string("K=2000 ") + (sorted ? "sorted" : "interleaved");
+        context.results.push_back({"state/issued", params, (double)perFrame.issued, "calls"});
+        context.results.push_back({"state/elided", params, (double)perFrame.elided, "calls"});
+        context.results.push_back({"state/submit", params, median(frameTimes) * 1e3, "ms"});
+    }
+
+    applyPointMode(POINT_MODE_DISCARD);
+    glViewport(0, 0, context.width, context.height);
+} /* benchState() */
@@ -0,0 +1,99 @@
+#include "bench.h"
+
+#include <glad.h>
+
+#include <frame_constants.h>
+#include <generator.h>
+#include <gl_resources.h>
+#include <shader.h>
+#include <stream_buffer.h>
+
+#define BENCH_POINTS 1000000
+#define WARMUP_FRAMES 5
+#define MEASURED_FRAMES 60
+
+/**
+ * Streams N animated points to the GPU every frame and draws them, comparing
+ * glBufferSubData into one buffer, orphaning with glBufferData and the persistently
+ * mapped StreamBuffer. Frames are not finished one by one, so stalls on a buffer the
+ * GPU still reads show up in the CPU upload time and in the frame rate.
+ */
+void benchStreaming(BenchContext& context) {
+    std::vector<vec3local> rest(BENCH_POINTS), displaced(BENCH_POINTS);
+    populate3Darray(rest.data(), BENCH_POINTS, 0.9f);
+    const GLsizeiptr size = sizeof(vec3local) * BENCH_POINTS;
+
+    Program shader(Shader((context.shaderDir / "vertex.glsl").string(),
+                          (context.shaderDir / "fragment.glsl").string()));
+    FrameConstantsBuffer frameConstantsBuffer;
+    FrameConstants frameConstants;
+
+    enum Method { SUB_DATA, ORPHAN, PERSISTENT };
+    const std::pair<Method, const char*> methods[] = {
+        {SUB_DATA, "glBufferSubData"},
+        {ORPHAN, "glBufferData-orphan"},
+        {PERSISTENT, "persistent-ring"},
+    };
+
+    // a small target keeps rasterization from hiding the upload
+    glViewport(0, 0, 64, 64);
+    for (const auto& [method, name] : methods) {
+        Buffer pointBuffer;
+        StreamBuffer * stream = NULL;
+        VertexArray vertexArray;
+        if (method == PERSISTENT) {
+            stream = new StreamBuffer(size);
+            vertexArray.attribute(0, stream->ID, 3, GL_FLOAT, sizeof(vec3local));
+        } else {
+            pointBuffer.data(size, NULL, GL_STREAM_DRAW);
+            vertexArray.attribute(0, pointBuffer.ID, 3, GL_FLOAT, sizeof(vec3local));
+        }
+
+        std::vector<double> uploadTimes;
+        double start = 0.0;
+        for (int frame = 0; frame < WARMUP_FRAMES + MEASURED_FRAMES; frame++) {
+            if (frame == WARMUP_FRAMES) {
+                glFinish();
+                start = nowSeconds();
+            }
+            float time = frame * 0.016f;
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            frameConstants.time.x = time;
+            frameConstantsBuffer.update(frameConstants);
+
+            double uploadStart = nowSeconds();
+            GLint first = 0;
+            if (method == PERSISTENT) {
+                displacePoints(rest.data(), static_cast<vec3local*>(stream->begin()), BENCH_POINTS, time, 0.05f);
+                stream->end();
+                first = (GLint)(stream->offset() / sizeof(vec3local));
+            } else {
+                displacePoints(rest.data(), displaced.data(), BENCH_POINTS, time, 0.05f);
+                if (method == ORPHAN) {
+                    pointBuffer.data(size, displaced.data(), GL_STREAM_DRAW);
+                } else {
+                    pointBuffer.subData(0, size, displaced.data());
+                }
+            }
+            double uploaded = nowSeconds();
+
+            shader.use();
+            vertexArray.bind();
+            glDrawArrays(GL_POINTS, first, BENCH_POINTS);
+            glFlush();
+            if (frame >= WARMUP_FRAMES) {
+                uploadTimes.push_back(uploaded - uploadStart);
+            }
+        }
+        glFinish();
+        double frameTime = (nowSeconds() - start) / MEASURED_FRAMES;
+
+        delete stream;
+
+        std::string params = std::string("N=1M ") + name;
+        context.results.push_back({"streaming/cpu_upload", params, median(uploadTimes) * 1e3, "ms"});
+        context.results.push_back({"streaming/frame", params, frameTime * 1e3, "ms"});
+    }
+
+    glViewport(0, 0, context.width, context.height);
+} /* benchStreaming() */
@@ -0,0 +1,39 @@
+#include "bench.h"
+
+#include <glad.h>
+
+#include <trace.h>
+
+#define FRAMES 1000
+#define SCOPES_PER_FRAME 100
+
+/**
+ * Cost of one trace event: a CPU scope while no trace is recording (one branch),
+ * the same scope recording, and a GPU scope recording (two timestamp queries,
+ * collected once a frame as the program does).
+ */
+void benchTrace(BenchContext& context) {
+    const char* cases[] = {"cpu disabled", "cpu", "gpu"};
+    for (int mode = 0; mode < 3; mode++) {
+        if (mode > 0) {
+            Trace::start();
+        }
+        double start = nowSeconds();
+        for (int frame = 0; frame < FRAMES; frame++) {
+            Trace::collectGpu();
+            for (int i = 0; i < SCOPES_PER_FRAME; i++) {
+                if (mode == 2) {
+                    TraceGpuScope scope("inner");
+                } else {
+                    TraceScope scope("inner");
+                }
+            }
+        }
+        glFinish();
+        double perEvent = (nowSeconds() - start) / (FRAMES * SCOPES_PER_FRAME);
+        context.results.push_back({"trace/event", cases[mode], perEvent * 1e9, "ns"});
+    }
+    Trace::collectGpu();
+    Trace::stop();
+    Trace::terminate();
+} /* benchTrace() */
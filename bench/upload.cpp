@@ -0,0 +1,64 @@
+#include "bench.h"
+
+#include <cstring>
+
+#include <glad.h>
+
+#include <generator.h>
+#include <gl_resources.h>
+
+#define MIN_BYTES_PER_SAMPLE (64 << 20)
+#define SAMPLES 5
+
+/**
+ * Bandwidth of a one-off vertex buffer upload by strategy: immutable storage in a
+ * new buffer, reallocating with glBufferData, glBufferSubData into existing storage,
+ * and mapping with an invalidated range. Each upload is finished before the clock
+ * stops, so drivers that copy lazily are charged for the copy too.
+ */
+void benchUpload(BenchContext& context) {
+    const int counts[] = {1000, 100000, 1000000, 10000000};
+    enum Strategy { STORAGE, DATA, SUB_DATA, MAP };
+    const std::pair<Strategy, const char*> strategies[] = {
+        {STORAGE, "glBufferStorage"},
+        {DATA, "glBufferData"},
+        {SUB_DATA, "glBufferSubData"},
+        {MAP, "glMapBufferRange"},
+    };
+
+    for (int count : counts) {
+        std::vector<vec3local> points(count);
+        populate3Darray(points.data(), count, 0.9f);
+        const GLsizeiptr size = sizeof(vec3local) * count;
+        int repeats = std::max<GLsizeiptr>(1, MIN_BYTES_PER_SAMPLE / size);
+
+        for (const auto& [strategy, name] : strategies) {
+            Buffer existing;
+            existing.data(size, NULL, GL_STATIC_DRAW);
+            std::vector<double> times;
+            for (int sample = 0; sample < SAMPLES; sample++) {
+                double start = nowSeconds();
+                for (int repeat = 0; repeat < repeats; repeat++) {
+                    if (strategy == STORAGE) {
+                        Buffer buffer;
+                        buffer.storage(size, points.data());
+                    } else if (strategy == DATA) {
+                        existing.data(size, points.data(), GL_STATIC_DRAW);
+                    } else if (strategy == SUB_DATA) {
+                        existing.subData(0, size, points.data());
+                    } else {
+                        GLState::bindBuffer(GL_COPY_WRITE_BUFFER, existing.ID);
+                        void* mapped = glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, size,
+                                                        GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+                        memcpy(mapped, points.data(), size);
+                        glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+                    }
+                }
+                glFinish();
+                times.push_back((nowSeconds() - start) / repeats);
+            }
+            std::string params = std::string(name) + " N=" + std::to_string(count);
+            context.results.push_back({"upload/bandwidth", params, size / median(times) / 1e9, "GB/s"});
+        }
+    }
+} /* benchUpload() */
@@ -0,0 +1,181 @@
+#ifndef ARCBALL_H
+#define ARCBALL_H
+
+#include <algorithm>
+#include <cmath>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+// Where a drag had the sphere at its last cursor event and how fast it was turning
+struct ArcballSample
+{
+    static constexpr double MAX_PREDICTION = 0.05;     // seconds past the last event
+
+    glm::quat orientation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+    glm::vec3 velocity = glm::vec3(0.0f);               // rotation axis times radians per second
+    double time = 0.0;                                  // seconds
+
+    /**
+     * The orientation extrapolated to a later time, e.g. when the frame reaches the
+     * screen. It runs ahead of the last event by up to MAX_PREDICTION and, if no newer
+     * event arrives, eases back to it over as long again: the cursor has stopped.
+     */
+    glm::quat predict(double when) const
+    {
+        double ahead = when - time;
+        if (ahead > MAX_PREDICTION)
+            ahead = 2.0 * MAX_PREDICTION - ahead;
+        float angle = glm::length(velocity) * (float)std::max(0.0, ahead);
+        if (angle <= 0.0f)
+            return orientation;
+        return glm::normalize(glm::angleAxis(angle, glm::normalize(velocity)) * orientation);
+    }
+
+    // True while predict() still differs from the orientation
+    bool moving(double now) const
+    {
+        return now - time < 2.0 * MAX_PREDICTION && glm::length(velocity) > 0.0f;
+    }
+};
+
+/**
+ * Turns cursor drags into rotations (Shoemake's arcball): the cursor is projected
+ * onto a ball filling the largest centered square of the window, and the sphere
+ * turns with the point under it. Orientations compose as quaternions, so drags
+ * accumulate without drift or jumps.
+ *
+ * Each event also updates an angular velocity, averaged over about SMOOTHING seconds,
+ * which ArcballSample::predict() uses to show the drag where it will be rather than
+ * where it was.
+ */
+class Arcball
+{
+public:
+    static constexpr double SMOOTHING = 0.03;     // seconds
+
+    // The window size in cursor coordinates
+    void resize(int width, int height)
+    {
+        centerX = width / 2.0;
+        centerY = height / 2.0;
+        radius = std::max(1, std::min(width, height)) / 2.0;
+    }
+
+    void press(double x, double y, double time)
+    {
+        from = project(x, y);
+        current.velocity = glm::vec3(0.0f);
+        current.time = time;
+        active = true;
+    }
+
+    void drag(double x, double y, double time)
+    {
+        if (!active)
+            return;
+        glm::vec3 to = project(x, y);
+        glm::vec3 axis = glm::cross(from, to);
+        float cosine = glm::dot(from, to);
+        from = to;
+        if (1.0f + cosine < 1e-6f)
+            return;
+
+        // The quaternion for the arc between the two points, by way of their half-way vector
+        current.orientation = glm::normalize(glm::quat(1.0f + cosine, axis.x, axis.y, axis.z) * current.orientation);
+        double elapsed = time - current.time;
+        if (elapsed <= 0.0)
+            return;
+        float sine = glm::length(axis);
+        glm::vec3 velocity = sine > 0.0f ? axis / sine * std::atan2(sine, cosine) / (float)elapsed : glm::vec3(0.0f);
+        current.velocity += (velocity - current.velocity) * (float)(1.0 - std::exp(-elapsed / SMOOTHING));
+        current.time = time;
+    }
+
+    // The sphere stays where it was let go
+    void release(double time)
+    {
+        current.velocity = glm::vec3(0.0f);
+        current.time = time;
+        active = false;
+    }
+
+    bool dragging() const
+    {
+        return active;
+    }
+
+    const ArcballSample& sample() const
+    {
+        return current;
+    }
+
+private:
+    ArcballSample current;
+    glm::vec3 from = glm::vec3(0.0f, 0.0f, 1.0f);
+    double centerX = 0.0, centerY = 0.0, radius = 1.0;
+    bool active = false;
+
+    // A window point on the ball, +z facing the viewer; outside it, on its rim
+    glm::vec3 project(double x, double y) const
+    {
+        glm::vec3 point((float)((x - centerX) / radius), (float)((centerY - y) / radius), 0.0f);
+        float lengthSquared = glm::dot(point, point);
+        if (lengthSquared >= 1.0f)
+            return point / std::sqrt(lengthSquared);
+        point.z = std::sqrt(1.0f - lengthSquared);
+        return point;
+    }
+};
+
+/**
+ * Predicts when a frame reaches the screen and how late its input can be taken.
+ * It assumes that a buffer swap returns at a vsync, as it does with a swap interval
+ * of 1, and keeps the longest recent time from taking the input to the swap.
+ */
+class DisplayClock
+{
+public:
+    static constexpr double MARGIN = 0.002;     // seconds kept free before the vsync
+
+    double refreshInterval;
+
+    explicit DisplayClock(double refreshRate)
+        : refreshInterval(1.0 / std::max(1.0, refreshRate))
+    {
+    }
+
+    /**
+     * After each swap returns
+     *
+     * @param now The current time in seconds
+     * @param renderSeconds From taking the frame's input to swapping it
+     */
+    void swapped(double now, double renderSeconds)
+    {
+        lastVsync = now;
+        renderTime = std::max(renderSeconds, renderTime * 0.95);
+    }
+
+    // The first vsync a frame started now can make
+    double nextVsync(double now) const
+    {
+        double ready = now + renderTime + MARGIN;
+        if (lastVsync <= 0.0)
+            return ready;
+        double intervals = std::max(1.0, std::ceil((ready - lastVsync) / refreshInterval));
+        return lastVsync + intervals * refreshInterval;
+    }
+
+    // The latest time to take the input of a frame shown at the given vsync
+    double latchTime(double vsync) const
+    {
+        return vsync - renderTime - MARGIN;
+    }
+
+private:
+    double lastVsync = 0.0;
+    double renderTime = 0.0;
+};
+
+#endif  // ARCBALL_H
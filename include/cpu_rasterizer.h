@@ -0,0 +1,346 @@
+#ifndef CPU_RASTERIZER_H
+#define CPU_RASTERIZER_H
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <frame_constants.h>
+#include <generator.h>
+#include <profiler.h>
+#include <shader.h>
+
+// The AVX2 kernels are compiled per function and picked at run time, so the
+// build needs no -mavx2 and the binary still runs on older CPUs
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define CPU_RASTERIZER_AVX2 1
+#include <immintrin.h>
+#else
+#define CPU_RASTERIZER_AVX2 0
+#endif
+
+/**
+ * Renders the point sphere without a GPU: vertex.glsl's transform and point-size
+ * mapping and fragment.glsl's round points and depth coloring, with the GL
+ * rasterization rules, into an RGBA8 color buffer and a float depth buffer.
+ *
+ * A frame runs in two parallel passes. The first transforms a contiguous range of
+ * points per thread and bins each point into the screen tiles it touches. The
+ * second gives each thread whole tiles and splats their bins in submission order
+ * (thread 0's range first), so overlapping points resolve exactly as in GL, and
+ * no two threads ever write the same pixel. Splatting handles eight pixels of a
+ * row at once with AVX2 when the CPU has it.
+ *
+ * Pixels are stored bottom row first, like glReadPixels returns them.
+ */
+class CpuRasterizer
+{
+public:
+    static const int TILE_SIZE = 64;
+
+    // Shader constants, as in SHADER_CONSTANTS; see setConstants()
+    float pointSizeOffset = 0.5f;
+    float pointSizeDivisor = 0.23f;
+    float depthThreshold = 0.3f;
+    float backCullZ = -2.0f;
+
+    bool roundPoints = true;        // false draws square sprites (POINT_MODE_SQUARE)
+    bool depthTest = false;         // GL_LESS against the depth buffer; off in the GL path
+    float maxPointSize = 0.0f;      // larger points are clamped, as GL_POINT_SIZE_RANGE does; 0 is no limit
+    glm::vec4 clearColor = glm::vec4(0.0f);
+
+    CpuRasterizer(int width, int height, int threads = 0)
+        : width(width), height(height),
+          threads(threads > 0 ? threads : std::max(1u, std::thread::hardware_concurrency())),
+          color((size_t)width * height), depth((size_t)width * height)
+    {
+        tileColumns = (width + TILE_SIZE - 1) / TILE_SIZE;
+        tileRows = (height + TILE_SIZE - 1) / TILE_SIZE;
+        bins.resize((size_t)this->threads * tileColumns * tileRows);
+        setViewport(0, 0, width, height);
+    }
+
+    // Reads the values the shaders are specialized with
+    void setConstants(const std::vector<ShaderConstant>& constants)
+    {
+        for (const ShaderConstant& constant : constants)
+        {
+            if (constant.name == "POINT_SIZE_OFFSET")
+                pointSizeOffset = constant.value;
+            else if (constant.name == "POINT_SIZE_DIVISOR")
+                pointSizeDivisor = constant.value;
+            else if (constant.name == "DEPTH_THRESHOLD")
+                depthThreshold = constant.value;
+            else if (constant.name == "BACK_CULL_Z")
+                backCullZ = constant.value;
+        }
+    }
+
+    // Same meaning as glViewport
+    void setViewport(int x, int y, int viewportWidth, int viewportHeight)
+    {
+        viewportScale = glm::vec2(viewportWidth * 0.5f, viewportHeight * 0.5f);
+        viewportOffset = glm::vec2(x + viewportScale.x, y + viewportScale.y);
+    }
+
+    static bool simd()
+    {
+        #if CPU_RASTERIZER_AVX2
+        return __builtin_cpu_supports("avx2");
+        #else
+        return false;
+        #endif
+    }
+
+    int threadCount() const
+    {
+        return threads;
+    }
+
+    /**
+     * Clears the buffers and draws the points in order, one frame.
+     *
+     * @param points The points in model space
+     * @param count The number of points
+     * @param constants The frame's rotation, projection, colors and point scale
+     */
+    void render(const vec3local * points, int count, const FrameConstants& constants)
+    {
+        for (std::vector<Splat>& bin : bins)
+            bin.clear();
+        backColor = packColor(constants.backColor);
+        frontColor = packColor(constants.frontColor);
+
+        PROFILE_SCOPE("rasterize");
+        {
+            PROFILE_SCOPE("bin");
+            parallel([&](int thread) {
+                const int first = (int)((long long)count * thread / threads);
+                const int last = (int)((long long)count * (thread + 1) / threads);
+                binPoints(points, first, last, constants, &bins[(size_t)thread * tileColumns * tileRows]);
+            });
+        }
+
+        PROFILE_SCOPE("splat");
+        std::atomic<int> nextTile(0);
+        const bool avx2 = simd();
+        parallel([&](int) {
+            for (int tile = nextTile++; tile < tileColumns * tileRows; tile = nextTile++)
+                drawTile(tile, avx2);
+        });
+    }
+
+    // RGBA8 pixels, bottom row first
+    const uint32_t* pixels() const
+    {
+        return color.data();
+    }
+
+    const float* depthBuffer() const
+    {
+        return depth.data();
+    }
+
+private:
+    // A point in window coordinates, as the rasterizer sees it
+    struct Splat
+    {
+        float x, y;         // center
+        float size;         // gl_PointSize
+        float z;            // gl_FragCoord.z
+    };
+
+    int width, height, threads;
+    int tileColumns, tileRows;
+    glm::vec2 viewportScale, viewportOffset;
+    uint32_t backColor = 0, frontColor = 0;
+    std::vector<uint32_t> color;
+    std::vector<float> depth;
+    std::vector<std::vector<Splat>> bins;     // [thread][tile]
+
+    // Runs job(thread) on every thread and waits for all of them
+    void parallel(const std::function<void(int)>& job)
+    {
+        std::vector<std::thread> workers;
+        for (int thread = 1; thread < threads; thread++)
+            workers.emplace_back(job, thread);
+        job(0);
+        for (std::thread& worker : workers)
+            worker.join();
+    }
+
+    static uint32_t packColor(const glm::vec4& value)
+    {
+        glm::vec4 unorm = glm::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f;
+        return (uint32_t)unorm.r | (uint32_t)unorm.g << 8 | (uint32_t)unorm.b << 16 | (uint32_t)unorm.a << 24;
+    }
+
+    // vertex.glsl, clipping and the viewport transform for points [first, last)
+    void binPoints(const vec3local * points, int first, int last, const FrameConstants& constants,
+                   std::vector<Splat> * threadBins) const
+    {
+        const glm::mat4 transform = constants.projection * constants.rotation;
+        const glm::vec4 rotationZ(constants.rotation[0][2], constants.rotation[1][2], constants.rotation[2][2], constants.rotation[3][2]);
+        for (int i = first; i < last; i++)
+        {
+            const glm::vec4 position(points[i].x, points[i].y, points[i].z, 1.0f);
+            if (glm::dot(rotationZ, position) < backCullZ)
+                continue;
+            const glm::vec4 clip = transform * position;
+            // a point is dropped whole when its center is outside the clip volume
+            if (!(std::fabs(clip.x) <= clip.w && std::fabs(clip.y) <= clip.w && std::fabs(clip.z) <= clip.w))
+                continue;
+
+            Splat splat;
+            float size = (clip.z + pointSizeOffset) / pointSizeDivisor * constants.pointScale.x;
+            size = std::max(size, 1.0f);
+            if (maxPointSize > 0.0f)
+                size = std::min(size, maxPointSize);
+            splat.size = size;
+            splat.x = clip.x / clip.w * viewportScale.x + viewportOffset.x;
+            splat.y = clip.y / clip.w * viewportScale.y + viewportOffset.y;
+            splat.z = clip.z / clip.w * 0.5f + 0.5f;
+
+            int x0, y0, x1, y1;
+            if (!coveredPixels(splat, 0, 0, width, height, x0, y0, x1, y1))
+                continue;
+            for (int row = y0 / TILE_SIZE; row <= y1 / TILE_SIZE; row++)
+            {
+                for (int column = x0 / TILE_SIZE; column <= x1 / TILE_SIZE; column++)
+                    threadBins[row * tileColumns + column].push_back(splat);
+            }
+        }
+    }
+
+    // Pixels whose centers fall in the point's square, limited to a rectangle; inclusive
+    static bool coveredPixels(const Splat& splat, int left, int bottom, int right, int top,
+                              int& x0, int& y0, int& x1, int& y1)
+    {
+        const float radius = splat.size * 0.5f;
+        x0 = std::max(left, (int)std::ceil(splat.x - radius - 0.5f));
+        y0 = std::max(bottom, (int)std::ceil(splat.y - radius - 0.5f));
+        x1 = std::min(right - 1, (int)std::floor(splat.x + radius - 0.5f));
+        y1 = std::min(top - 1, (int)std::floor(splat.y + radius - 0.5f));
+        return x0 <= x1 && y0 <= y1;
+    }
+
+    // Clears the tile and splats every point binned to it, in submission order
+    void drawTile(int tile, bool avx2)
+    {
+        const int left = (tile % tileColumns) * TILE_SIZE;
+        const int bottom = (tile / tileColumns) * TILE_SIZE;
+        const int right = std::min(left + TILE_SIZE, width);
+        const int top = std::min(bottom + TILE_SIZE, height);
+
+        const uint32_t clear = packColor(clearColor);
+        for (int y = bottom; y < top; y++)
+        {
+            std::fill(&color[(size_t)y * width + left], &color[(size_t)y * width + right], clear);
+            std::fill(&depth[(size_t)y * width + left], &depth[(size_t)y * width + right], 1.0f);
+        }
+
+        for (int thread = 0; thread < threads; thread++)
+        {
+            const std::vector<Splat>& bin = bins[(size_t)thread * tileColumns * tileRows + tile];
+            #if CPU_RASTERIZER_AVX2
+            if (avx2)
+            {
+                splatAVX2(bin, left, bottom, right, top);
+                continue;
+            }
+            #endif
+            splatScalar(bin, left, bottom, right, top);
+        }
+    }
+
+    // fragment.glsl for every covered pixel: the circle test on gl_PointCoord, then
+    // backColor or frontColor by depth
+    void splatScalar(const std::vector<Splat>& bin, int left, int bottom, int right, int top)
+    {
+        for (const Splat& splat : bin)
+        {
+            int x0, y0, x1, y1;
+            if (!coveredPixels(splat, left, bottom, right, top, x0, y0, x1, y1))
+                continue;
+            const float inverseSize = 1.0f / splat.size;
+            const uint32_t value = splat.z < depthThreshold ? backColor : frontColor;
+            for (int y = y0; y <= y1; y++)
+            {
+                const float dy = ((float)y + 0.5f - splat.y) * inverseSize;
+                const float dy2 = dy * dy;
+                uint32_t* colorRow = &color[(size_t)y * width];
+                float* depthRow = &depth[(size_t)y * width];
+                for (int x = x0; x <= x1; x++)
+                {
+                    const float dx = ((float)x + 0.5f - splat.x) * inverseSize;
+                    if (roundPoints && dx * dx + dy2 > 0.25f)
+                        continue;
+                    if (depthTest)
+                    {
+                        if (!(splat.z < depthRow[x]))
+                            continue;
+                        depthRow[x] = splat.z;
+                    }
+                    colorRow[x] = value;
+                }
+            }
+        }
+    }
+
+    #if CPU_RASTERIZER_AVX2
+    // splatScalar() eight pixels at a time; the same float operations, so the same pixels
+    __attribute__((target("avx2")))
+    void splatAVX2(const std::vector<Splat>& bin, int left, int bottom, int right, int top)
+    {
+        const __m256 pixelCenters = _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f);
+        const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+        const __m256 quarter = _mm256_set1_ps(0.25f);
+        for (const Splat& splat : bin)
+        {
+            int x0, y0, x1, y1;
+            if (!coveredPixels(splat, left, bottom, right, top, x0, y0, x1, y1))
+                continue;
+            const float inverseSize = 1.0f / splat.size;
+            const __m256 centerX = _mm256_set1_ps(splat.x);
+            const __m256 inverse = _mm256_set1_ps(inverseSize);
+            const __m256 z = _mm256_set1_ps(splat.z);
+            const __m256i value = _mm256_set1_epi32((int)(splat.z < depthThreshold ? backColor : frontColor));
+            for (int y = y0; y <= y1; y++)
+            {
+                const float dy = ((float)y + 0.5f - splat.y) * inverseSize;
+                const __m256 dy2 = _mm256_set1_ps(dy * dy);
+                uint32_t* colorRow = &color[(size_t)y * width];
+                float* depthRow = &depth[(size_t)y * width];
+                for (int x = x0; x <= x1; x += 8)
+                {
+                    // lanes past x1 are masked off, so loads and stores never leave the row
+                    __m256i mask = _mm256_cmpgt_epi32(_mm256_set1_epi32(x1 - x + 1), lanes);
+                    if (roundPoints)
+                    {
+                        const __m256 centers = _mm256_add_ps(_mm256_set1_ps((float)x), pixelCenters);
+                        const __m256 dx = _mm256_mul_ps(_mm256_sub_ps(centers, centerX), inverse);
+                        const __m256 distance = _mm256_add_ps(_mm256_mul_ps(dx, dx), dy2);
+                        mask = _mm256_and_si256(mask, _mm256_castps_si256(_mm256_cmp_ps(distance, quarter, _CMP_LE_OQ)));
+                    }
+                    if (depthTest)
+                    {
+                        const __m256 stored = _mm256_maskload_ps(depthRow + x, mask);
+                        mask = _mm256_and_si256(mask, _mm256_castps_si256(_mm256_cmp_ps(z, stored, _CMP_LT_OQ)));
+                        _mm256_maskstore_ps(depthRow + x, mask, z);
+                    }
+                    _mm256_maskstore_epi32((int*)(colorRow + x), mask, value);
+                }
+            }
+        }
+    }
+    #endif
+};
+
+#endif  // CPU_RASTERIZER_H
@@ -0,0 +1,65 @@
+#ifndef DEPTH_SORT_H
+#define DEPTH_SORT_H
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include <generator.h>
+
+/**
+ * Maps a float to a uint whose unsigned order matches the float order, so floats
+ * can be radix sorted: negative values have every bit flipped, positive values
+ * only the sign bit.
+ */
+inline uint32_t sortableFloatKey(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+} /* sortableFloatKey() */
+
+/**
+ * Orders the points back to front for blending: increasing rotated z, the order
+ * that matches vertex.glsl's point-size mapping (larger z, larger and nearer point).
+ * A stable LSD radix sort over 8-bit digits, so its output is exactly reproducible.
+ *
+ * @param points The points in model space
+ * @param count The number of points
+ * @param rotation The rotation applied by the vertex shader
+ * @param indices Receives the point indices in drawing order
+ */
+inline void depthSortCPU(const vec3local * points, int count, const glm::mat4& rotation,
+                         std::vector<uint32_t>& indices) {
+    // rotated z of p is dot(p, third row of the rotation) plus the translation
+    glm::vec4 row(rotation[0][2], rotation[1][2], rotation[2][2], rotation[3][2]);
+    std::vector<uint32_t> keys(count), keysTemp(count), indicesTemp(count);
+    indices.resize(count);
+    for (int i = 0; i < count; i++) {
+        keys[i] = sortableFloatKey(row.x * points[i].x + row.y * points[i].y + row.z * points[i].z + row.w);
+        indices[i] = i;
+    }
+
+    for (int shift = 0; shift < 32; shift += 8) {
+        uint32_t offsets[256] = {0};
+        for (int i = 0; i < count; i++) {
+            offsets[(keys[i] >> shift) & 0xFF]++;
+        }
+        uint32_t sum = 0;
+        for (int digit = 0; digit < 256; digit++) {
+            uint32_t size = offsets[digit];
+            offsets[digit] = sum;
+            sum += size;
+        }
+        for (int i = 0; i < count; i++) {
+            uint32_t destination = offsets[(keys[i] >> shift) & 0xFF]++;
+            keysTemp[destination] = keys[i];
+            indicesTemp[destination] = indices[i];
+        }
+        keys.swap(keysTemp);
+        indices.swap(indicesTemp);
+    }
+} /* depthSortCPU() */
+
+#endif  // DEPTH_SORT_H
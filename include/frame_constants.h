@@ -0,0 +1,67 @@
+#ifndef FRAME_CONSTANTS_H
+#define FRAME_CONSTANTS_H
+
+#include <glad.h>
+
+#include <glm/glm.hpp>
+
+#include <cstring>
+
+#include <gl_state.h>
+#include <stream_buffer.h>
+
+// Binding point of the FrameConstants uniform block in every program
+const unsigned int FRAME_CONSTANTS_BINDING = 0;
+
+// Per-frame state shared by all programs. The layout matches the std140
+// FrameConstants block declared in the shaders, so only mat4/vec4 members.
+struct FrameConstants
+{
+    glm::mat4 rotation   = glm::mat4(1.0f);
+    glm::mat4 projection = glm::mat4(1.0f);
+    glm::vec4 backColor  = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);     // depth below DEPTH_THRESHOLD; larger z is nearer
+    glm::vec4 frontColor = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
+    glm::vec4 viewport   = glm::vec4(0.0f);     // x, y = size in pixels; z, w = 1 / size
+    glm::vec4 time       = glm::vec4(0.0f);     // x = seconds since start, y = frame delta
+    glm::vec4 pointScale = glm::vec4(1.0f, 0.0f, 0.0f, 0.0f);     // x = factor on gl_PointSize, for tiled renders
+};
+
+/**
+ * Triple-buffered uniform buffer holding the FrameConstants block, a StreamBuffer
+ * with one region per frame. With persistent mapping a frame costs one memcpy and
+ * one glBindBufferRange; the StreamBuffer's fences keep the CPU from overwriting
+ * constants the GPU is still reading.
+ */
+class FrameConstantsBuffer
+{
+public:
+    static const int FRAMES = 3;
+
+    explicit FrameConstantsBuffer(BufferStrategy strategy = BUFFER_PERSISTENT)
+        : stream(sizeof(FrameConstants), FRAMES, uniformBufferAlignment(), strategy)
+    {
+    }
+
+    /**
+     * Writes this frame's constants into the next slot and binds that slot to
+     * FRAME_CONSTANTS_BINDING. Call once per frame before drawing.
+     */
+    void update(const FrameConstants& constants)
+    {
+        std::memcpy(stream.begin(), &constants, sizeof(FrameConstants));
+        stream.end();
+        GLState::bindBufferRange(GL_UNIFORM_BUFFER, FRAME_CONSTANTS_BINDING, stream.ID, stream.offset(), sizeof(FrameConstants));
+    }
+
+private:
+    StreamBuffer stream;
+
+    static GLsizeiptr uniformBufferAlignment()
+    {
+        int alignment = 0;
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+        return alignment < 1 ? 256 : alignment;
+    }
+};
+
+#endif  // FRAME_CONSTANTS_H
@@ -0,0 +1,334 @@
+#ifndef FRAME_ENCODER_H
+#define FRAME_ENCODER_H
+
+#include <algorithm>
+#include <condition_variable>
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <trace.h>
+
+/**
+ * Writes frames to disk on a background thread, so encoding never holds up the
+ * render loop. The output depends on the path:
+ *  - "-" streams YUV4MPEG2 (Y4M) to stdout, e.g. for piping into ffmpeg
+ *  - a path ending in ".y4m" writes one Y4M file
+ *  - anything else is a printf pattern for numbered PNG files, e.g. "frames/%05d.png",
+ *    with exactly one integer conversion and otherwise only "%%"
+ *
+ * Y4M frames are 4:4:4 BT.601 studio-range YUV. PNGs are RGB, written with
+ * uncompressed deflate blocks: larger files, but encoding costs about as much as a copy.
+ *
+ * submit() copies the frame into a recycled buffer and returns; it only blocks when
+ * queueLength frames are already waiting, so a slow disk slows the loop down
+ * instead of filling memory.
+ */
+class FrameEncoder
+{
+public:
+    FrameEncoder(const std::string& path, int width, int height, int fps = 60, int queueLength = 4)
+        : path(path), width(width), height(height), fps(fps), queueLength(queueLength)
+    {
+        y4m = path == "-" || (path.size() > 4 && path.compare(path.size() - 4, 4, ".y4m") == 0);
+        if (y4m)
+        {
+            file = path == "-" ? stdout : fopen(path.c_str(), "wb");
+            if (file == NULL)
+            {
+                std::cerr << "ERROR::ENCODER::CANNOT_WRITE " << path << std::endl;
+                return;
+            }
+            fprintf(file, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C444\n", width, height, fps);
+        }
+        else
+        {
+            if (!numberPattern(path))
+            {
+                std::cerr << "ERROR::ENCODER::INVALID_PATTERN " << path << " (needs one frame number, e.g. frames/%05d.png)" << std::endl;
+                return;
+            }
+            patternValid = true;
+            buildCrcTable();
+        }
+        worker = std::thread(&FrameEncoder::run, this);
+    }
+
+    ~FrameEncoder()
+    {
+        finish();
+    }
+
+    bool valid() const
+    {
+        return y4m ? file != NULL : patternValid;
+    }
+
+    // Queues one frame of width * height RGBA pixels, bottom row first (as glReadPixels returns them)
+    void submit(const unsigned char* rgba)
+    {
+        TRACE_SCOPE("submit frame");
+        std::vector<unsigned char> frame;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            spaceAvailable.wait(lock, [this] { return (int)queue.size() < queueLength; });
+            if (!spare.empty())
+            {
+                frame = std::move(spare.back());
+                spare.pop_back();
+            }
+        }
+        frame.assign(rgba, rgba + (size_t)width * height * 4);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            queue.push_back(std::move(frame));
+        }
+        frameAvailable.notify_one();
+    }
+
+    // True for a printf pattern that takes exactly one int: one of %d, %i, %u, %o, %x or %X,
+    // with flags, width and precision but no length modifier, and no other conversion but %%
+    static bool numberPattern(const std::string& pattern)
+    {
+        int conversions = 0;
+        for (size_t i = 0; i < pattern.size(); i++)
+        {
+            if (pattern[i] != '%')
+                continue;
+            if (++i < pattern.size() && pattern[i] == '%')
+                continue;
+            while (i < pattern.size() && strchr("-+ #0", pattern[i]) != NULL)
+                i++;
+            while (i < pattern.size() && isdigit((unsigned char)pattern[i]))
+                i++;
+            if (i < pattern.size() && pattern[i] == '.')
+            {
+                i++;
+                while (i < pattern.size() && isdigit((unsigned char)pattern[i]))
+                    i++;
+            }
+            if (i >= pattern.size() || strchr("diuoxX", pattern[i]) == NULL)
+                return false;
+            conversions++;
+        }
+        return conversions == 1;
+    }
+
+    // Writes every queued frame and closes the output
+    void finish()
+    {
+        if (!worker.joinable())
+            return;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            finishing = true;
+        }
+        frameAvailable.notify_one();
+        worker.join();
+        if (file != NULL && file != stdout)
+            fclose(file);
+        else if (file == stdout)
+            fflush(stdout);
+        file = NULL;
+    }
+
+    int framesWritten() const
+    {
+        return written;
+    }
+
+    // The rate the frames are played back at
+    int framesPerSecond() const
+    {
+        return fps;
+    }
+
+private:
+    std::string path;
+    int width, height, fps, queueLength;
+    bool y4m;
+    bool patternValid = false;
+    FILE* file = NULL;
+
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable frameAvailable, spaceAvailable;
+    std::deque<std::vector<unsigned char>> queue;
+    std::vector<std::vector<unsigned char>> spare;      // written frames, reused by submit()
+    bool finishing = false;
+    int written = 0;
+
+    uint32_t crcTable[256];
+    std::vector<unsigned char> scratch;
+
+    void run()
+    {
+        Trace::setThreadName("encoder");
+        for (;;)
+        {
+            std::vector<unsigned char> frame;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                frameAvailable.wait(lock, [this] { return !queue.empty() || finishing; });
+                if (queue.empty())
+                    return;
+                frame = std::move(queue.front());
+                queue.pop_front();
+            }
+            spaceAvailable.notify_one();
+
+            {
+                TRACE_SCOPE("encode frame");
+                if (y4m)
+                    writeY4M(frame);
+                else
+                    writePNG(frame);
+            }
+            written++;
+
+            std::lock_guard<std::mutex> lock(mutex);
+            spare.push_back(std::move(frame));
+        }
+    }
+
+    void writeY4M(const std::vector<unsigned char>& rgba)
+    {
+        const size_t pixels = (size_t)width * height;
+        scratch.resize(pixels * 3);
+        unsigned char* planes[3] = {scratch.data(), scratch.data() + pixels, scratch.data() + 2 * pixels};
+        size_t i = 0;
+        for (int y = height - 1; y >= 0; y--)
+        {
+            const unsigned char* row = &rgba[(size_t)y * width * 4];
+            for (int x = 0; x < width; x++, i++)
+            {
+                int r = row[4 * x], g = row[4 * x + 1], b = row[4 * x + 2];
+                planes[0][i] = (unsigned char)(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+                planes[1][i] = (unsigned char)(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+                planes[2][i] = (unsigned char)(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+            }
+        }
+        fputs("FRAME\n", file);
+        fwrite(scratch.data(), 1, scratch.size(), file);
+    }
+
+    void writePNG(const std::vector<unsigned char>& rgba)
+    {
+        // scanlines: a filter byte (0, none) and RGB, top row first
+        const size_t stride = 1 + (size_t)width * 3;
+        scratch.resize(stride * height);
+        for (int y = 0; y < height; y++)
+        {
+            unsigned char* out = &scratch[y * stride];
+            const unsigned char* row = &rgba[(size_t)(height - 1 - y) * width * 4];
+            *out++ = 0;
+            for (int x = 0; x < width; x++)
+            {
+                *out++ = row[4 * x];
+                *out++ = row[4 * x + 1];
+                *out++ = row[4 * x + 2];
+            }
+        }
+
+        // zlib stream of stored deflate blocks, at most 65535 bytes each
+        std::vector<unsigned char> zlib = {0x78, 0x01};
+        const size_t blocks = (scratch.size() + 65534) / 65535;
+        zlib.reserve(scratch.size() + blocks * 5 + 6);
+        for (size_t offset = 0; offset < scratch.size(); offset += 65535)
+        {
+            uint16_t length = (uint16_t)std::min<size_t>(65535, scratch.size() - offset);
+            zlib.push_back(offset + length == scratch.size() ? 1 : 0);
+            zlib.push_back(length & 0xFF);
+            zlib.push_back(length >> 8);
+            zlib.push_back(~length & 0xFF);
+            zlib.push_back((uint16_t)~length >> 8);
+            zlib.insert(zlib.end(), scratch.begin() + offset, scratch.begin() + offset + length);
+        }
+        pushBigEndian(zlib, adler32(scratch.data(), scratch.size()));
+
+        char name[4096];
+        snprintf(name, sizeof(name), path.c_str(), written);
+        FILE* png = fopen(name, "wb");
+        if (png == NULL)
+        {
+            std::cerr << "ERROR::ENCODER::CANNOT_WRITE " << name << std::endl;
+            return;
+        }
+        static const unsigned char signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+        fwrite(signature, 1, sizeof(signature), png);
+        std::vector<unsigned char> header;
+        pushBigEndian(header, (uint32_t)width);
+        pushBigEndian(header, (uint32_t)height);
+        header.insert(header.end(), {8, 2, 0, 0, 0});       // 8-bit RGB, no interlacing
+        writeChunk(png, "IHDR", header);
+        writeChunk(png, "IDAT", zlib);
+        writeChunk(png, "IEND", {});
+        fclose(png);
+    }
+
+    void writeChunk(FILE* png, const char* type, const std::vector<unsigned char>& data)
+    {
+        std::vector<unsigned char> length;
+        pushBigEndian(length, (uint32_t)data.size());
+        fwrite(length.data(), 1, 4, png);
+        fwrite(type, 1, 4, png);
+        fwrite(data.data(), 1, data.size(), png);
+        uint32_t crc = update(0xFFFFFFFFu, (const unsigned char*)type, 4);
+        crc = update(crc, data.data(), data.size()) ^ 0xFFFFFFFFu;
+        std::vector<unsigned char> trailer;
+        pushBigEndian(trailer, crc);
+        fwrite(trailer.data(), 1, 4, png);
+    }
+
+    static void pushBigEndian(std::vector<unsigned char>& out, uint32_t value)
+    {
+        out.insert(out.end(), {(unsigned char)(value >> 24), (unsigned char)(value >> 16),
+                               (unsigned char)(value >> 8), (unsigned char)value});
+    }
+
+    static uint32_t adler32(const unsigned char* data, size_t size)
+    {
+        uint32_t a = 1, b = 0;
+        while (size > 0)
+        {
+            // the sums cannot overflow within 5552 bytes
+            size_t chunk = std::min<size_t>(size, 5552);
+            size -= chunk;
+            while (chunk-- > 0)
+            {
+                a += *data++;
+                b += a;
+            }
+            a %= 65521;
+            b %= 65521;
+        }
+        return b << 16 | a;
+    }
+
+    void buildCrcTable()
+    {
+        for (uint32_t n = 0; n < 256; n++)
+        {
+            uint32_t c = n;
+            for (int k = 0; k < 8; k++)
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            crcTable[n] = c;
+        }
+    }
+
+    uint32_t update(uint32_t crc, const unsigned char* data, size_t size) const
+    {
+        for (size_t i = 0; i < size; i++)
+            crc = crcTable[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+        return crc;
+    }
+};
+
+#endif  // FRAME_ENCODER_H
@@ -0,0 +1,68 @@
+#ifndef FRAME_PACER_H
+#define FRAME_PACER_H
+
+#include <algorithm>
+
+/**
+ * Decides when the next frame is worth drawing. A frame is due once the image can
+ * have changed by pixelThreshold pixels since the last one, and no sooner than
+ * 1 / targetFps after it. invalidate() makes the next frame due at once, for
+ * resizes, exposes and input.
+ *
+ * The caller sleeps until then: on glfwWaitEventsTimeout in a window, so events
+ * still wake it, or on the clock headless. A slow rotation then costs a few frames
+ * a second instead of one per swap interval.
+ */
+class FramePacer
+{
+public:
+    static constexpr double MAX_DELAY = 1.0;     // seconds; a still scene is redrawn this often
+
+    double targetFps;           // 0 for no limit
+    double pixelThreshold;      // 0 draws at targetFps whatever moves
+
+    FramePacer(double targetFps, double pixelThreshold)
+        : targetFps(targetFps), pixelThreshold(pixelThreshold)
+    {
+    }
+
+    /**
+     * Seconds from now until the next frame is due, 0 when it is due already
+     *
+     * @param now The current time in seconds
+     * @param pixelsPerSecond The fastest the image can change, e.g. PointSphere::pixelsPerSecond()
+     */
+    double delay(double now, double pixelsPerSecond) const
+    {
+        if (dirty)
+            return 0.0;
+        double interval = targetFps > 0.0 ? 1.0 / targetFps : 0.0;
+        if (pixelThreshold > 0.0)
+            interval = std::max(interval, pixelsPerSecond > 0.0 ? pixelThreshold / pixelsPerSecond : MAX_DELAY);
+        return std::max(0.0, lastFrame + std::min(interval, MAX_DELAY) - now);
+    }
+
+    void frameDrawn(double now)
+    {
+        lastFrame = now;
+        dirty = false;
+        frames++;
+    }
+
+    void invalidate()
+    {
+        dirty = true;
+    }
+
+    long framesDrawn() const
+    {
+        return frames;
+    }
+
+private:
+    double lastFrame = 0.0;
+    bool dirty = true;
+    long frames = 0;
+};
+
+#endif  // FRAME_PACER_H
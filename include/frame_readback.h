@@ -0,0 +1,102 @@
+#ifndef FRAME_READBACK_H
+#define FRAME_READBACK_H
+
+#include <glad.h>
+
+#include <functional>
+#include <vector>
+
+#include <gl_resources.h>
+#include <gl_state.h>
+
+/**
+ * Reads rendered frames back without stalling the pipeline.
+ *
+ * glReadPixels into client memory waits until the GPU has finished the frame.
+ * Here it writes into one of a ring of pixel pack buffers instead and returns at
+ * once; a fence marks when the copy is done. A buffer is only mapped when the ring
+ * comes back round to it, so with three buffers frame N is read while frames N + 1
+ * and N + 2 render, and mapping it rarely has to wait.
+ *
+ * Frames are handed to the sink as width * height RGBA pixels, bottom row first,
+ * valid only during the call.
+ */
+class FrameReadback
+{
+public:
+    using Sink = std::function<void(const unsigned char* rgba)>;
+
+    FrameReadback(int width, int height, int buffers = 3)
+        : width(width), height(height), pixelBuffers(buffers), fences(buffers, (GLsync)0)
+    {
+        for (Buffer& buffer : pixelBuffers)
+            buffer.data(frameSize(), NULL, GL_STREAM_READ);
+    }
+
+    FrameReadback(const FrameReadback&) = delete;
+    FrameReadback& operator=(const FrameReadback&) = delete;
+
+    ~FrameReadback()
+    {
+        for (GLsync fence : fences)
+        {
+            if (fence)
+                glDeleteSync(fence);
+        }
+    }
+
+    // Queues a copy of the framebuffer's lower-left width x height pixels. The
+    // frame captured `buffers` calls ago is handed to the sink first.
+    void capture(unsigned int framebuffer, const Sink& sink)
+    {
+        if (fences[next])
+            deliver(next, sink);
+
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+        GLState::bindBuffer(GL_PIXEL_PACK_BUFFER, pixelBuffers[next].ID);
+        glPixelStorei(GL_PACK_ALIGNMENT, 4);
+        glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        GLState::bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        fences[next] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        next = (next + 1) % (int)pixelBuffers.size();
+    }
+
+    // Hands every frame still in flight to the sink, oldest first
+    void flush(const Sink& sink)
+    {
+        for (size_t i = 0; i < pixelBuffers.size(); i++)
+        {
+            if (fences[next])
+                deliver(next, sink);
+            next = (next + 1) % (int)pixelBuffers.size();
+        }
+    }
+
+    size_t frameSize() const
+    {
+        return (size_t)width * height * 4;
+    }
+
+private:
+    int width, height;
+    std::vector<Buffer> pixelBuffers;
+    std::vector<GLsync> fences;     // set while a buffer holds a frame not yet delivered
+    int next = 0;
+
+    void deliver(int index, const Sink& sink)
+    {
+        GLenum result = glClientWaitSync(fences[index], GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+        while (result == GL_TIMEOUT_EXPIRED)
+            result = glClientWaitSync(fences[index], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);     // 1 ms
+        glDeleteSync(fences[index]);
+        fences[index] = 0;
+
+        Buffer& buffer = pixelBuffers[index];
+        const void* pixels = buffer.map(0, frameSize(), GL_MAP_READ_BIT);
+        if (pixels != NULL)
+            sink(static_cast<const unsigned char*>(pixels));
+        buffer.unmap();
+    }
+};
+
+#endif  // FRAME_READBACK_H
@@ -0,0 +1,155 @@
+#ifndef GENERATOR_H
+#define GENERATOR_H
+
+#include <math.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include <trace.h>
+
+typedef struct {
+    float x, y;
+} vec2local;
+
+typedef struct {
+    float x, y, z;
+} vec3local;
+
+// How the points are laid out on the sphere
+enum PointGenerator {
+    POINT_GENERATOR_SPIRAL = 0,     // populate3Darray()
+    POINT_GENERATOR_RANDOM = 1,     // populate3Drand()
+};
+
+inline const char* pointGeneratorName(PointGenerator generator) {
+    switch (generator) {
+        case POINT_GENERATOR_SPIRAL:    return "spiral";
+        case POINT_GENERATOR_RANDOM:    return "random";
+    }
+    return "unknown";
+} /* pointGeneratorName() */
+
+/**
+ * Populates the 2D array of points using the formula
+ * Derived from this paper: https://scholar.rose-hulman.edu/cgi/viewcontent.cgi?article=1387&context=rhumj
+ * 
+ * @param points2D The 2D array of points to populate
+ * @param numPoints The number of points in the array
+ * @see #populate3Darray()
+ */
+
+inline void populate2Darray(vec2local * points2D, int numPoints) {
+    float s = -1 + 1.0f /(numPoints - 1);
+    const float step_size = (2.0f - 2.0f/(numPoints - 1))/(numPoints - 1);
+    const float x = 0.1 + 1.2 * numPoints;
+
+    for (int i = 0; i < numPoints; i++, s += step_size) {
+        points2D[i].x = s * x;
+        // s accumulates rounding error, so clamp it before the sqrt at large N
+        points2D[i].y = M_PI/2 * copysignf(1.0f, s) * (1 - sqrt(std::max(0.0f, 1 - fabsf(s))));
+    }
+} /* populate2Darray() */
+
+/**
+ * Calculates the 3D coordinates from the 2D projection of the spiral
+ * Uses the {@link #populate2Darray(vec2local *, int)} function to create the 2D array
+ * of points.
+ *
+ * @param points3D The 3D array of points to populate
+ * @param numPoints The number of points in the array
+ * @param scale The radius of the sphere
+ */
+
+inline void populate3Darray(vec3local * points3D, int numPoints, float scale) {
+    TRACE_SCOPE("populate3Darray");
+    std::vector<vec2local> points2D(numPoints);
+    populate2Darray(points2D.data(), numPoints);
+    for (int i = 0; i < numPoints; i++) {
+        float u = points2D[i].x;
+        float v = points2D[i].y;
+
+        points3D[i].x = scale * cos(u) * cos(v);
+        points3D[i].y = scale * sin(u) * cos(v);
+        points3D[i].z = scale * sin(v);
+    }
+} /* populate3Darray() */
+
+/**
+ * Scatters the points randomly over the sphere
+ *
+ * @param points3D The 3D array of points to populate
+ * @param numPoints The number of points in the array
+ * @param scale The radius of the sphere
+ * @param seed Seeds the generator, so runs can repeat the same points
+ */
+
+inline void populate3Drand(vec3local * points3D, int numPoints, float scale, unsigned int seed = std::random_device()()) {
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<float> dis(-180.0, 180.0);
+
+    for (int i = 0; i < numPoints; i++) {
+        double theta = dis(gen);
+        double phi = dis(gen);
+
+        points3D[i].x = scale * sin(theta) * cos(phi);
+        points3D[i].y = scale * sin(theta) * sin(phi);
+        points3D[i].z = scale * cos(theta);
+    }
+} /* populate3Drand() */
+
+/**
+ * Reorders the points so that every prefix of the array is spread over the whole
+ * sphere. The spiral runs from pole to pole, so its first half is one hemisphere;
+ * visiting it in bit-reversed index order instead lets a level of detail draw just
+ * the first k points.
+ *
+ * @param points3D The points to reorder in place
+ * @param numPoints The number of points in the array
+ */
+
+inline void progressiveOrder(vec3local * points3D, int numPoints) {
+    int bits = 0;
+    while ((1LL << bits) < numPoints) {
+        bits++;
+    }
+
+    std::vector<vec3local> ordered;
+    ordered.reserve(numPoints);
+    for (long long i = 0; i < (1LL << bits); i++) {
+        long long reversed = 0;
+        for (int b = 0; b < bits; b++) {
+            reversed |= ((i >> b) & 1) << (bits - 1 - b);
+        }
+        if (reversed < numPoints) {
+            ordered.push_back(points3D[reversed]);
+        }
+    }
+    std::copy(ordered.begin(), ordered.end(), points3D);
+} /* progressiveOrder() */
+
+/**
+ * Displaces every point along its own direction by a few travelling waves, so the
+ * sphere ripples over time. Used by the animated mode, which streams the result to
+ * the GPU every frame.
+ *
+ * @param rest The undisplaced points
+ * @param displaced Receives the displaced points
+ * @param numPoints The number of points in both arrays
+ * @param time Seconds since the start
+ * @param amplitude The largest displacement, relative to the radius
+ */
+
+inline void displacePoints(const vec3local * rest, vec3local * displaced, int numPoints, float time, float amplitude) {
+    for (int i = 0; i < numPoints; i++) {
+        const vec3local& p = rest[i];
+        float wave = sinf(7.0f * p.x + 2.1f * time) * sinf(5.0f * p.y - 1.3f * time) * cosf(6.0f * p.z + 0.7f * time);
+        float factor = 1.0f + amplitude * wave;
+        displaced[i].x = p.x * factor;
+        displaced[i].y = p.y * factor;
+        displaced[i].z = p.z * factor;
+    }
+} /* displacePoints() */
+
+#endif  // GENERATOR_H
@@ -0,0 +1,375 @@
+#ifndef GL_RESOURCES_H
+#define GL_RESOURCES_H
+
+#include <glad.h>
+
+#include <utility>
+
+#include <gl_state.h>
+#include <trace.h>
+
+/**
+ * Owning wrappers for GL objects: the object is created with the wrapper and
+ * deleted with it, and moving hands it over. They must be destroyed while the
+ * context is still current.
+ *
+ * With GL 4.5 (or GL_ARB_direct_state_access) every edit names its object
+ * directly, so setting up a buffer, vertex array, texture or framebuffer binds
+ * nothing. On 3.3 the same calls fall back to binding the object to edit it.
+ */
+inline bool directStateAccess()
+{
+    return GLAD_GL_VERSION_4_5 || GLAD_GL_ARB_direct_state_access;
+}
+
+// Names from glGenBuffers only become buffers when first bound, and DSA calls
+// reject them until then; glCreateBuffers returns buffers that exist already
+inline void createBuffers(GLsizei count, unsigned int* buffers)
+{
+    if (directStateAccess())
+        glCreateBuffers(count, buffers);
+    else
+        glGenBuffers(count, buffers);
+}
+
+class Buffer
+{
+public:
+    unsigned int ID = 0;
+
+    Buffer()
+    {
+        createBuffers(1, &ID);
+    }
+
+    Buffer(const Buffer&) = delete;
+    Buffer& operator=(const Buffer&) = delete;
+
+    Buffer(Buffer&& other) noexcept : ID(std::exchange(other.ID, 0)) {}
+
+    Buffer& operator=(Buffer&& other) noexcept
+    {
+        std::swap(ID, other.ID);
+        return *this;
+    }
+
+    ~Buffer()
+    {
+        if (ID != 0)
+            GLState::deleteBuffers(1, &ID);
+    }
+
+    // Immutable storage where available (GL 4.4), plain glBufferData otherwise
+    void storage(GLsizeiptr size, const void* data, GLbitfield flags = 0)
+    {
+        TRACE_SCOPE("buffer upload");
+        if (directStateAccess())
+        {
+            glNamedBufferStorage(ID, size, data, flags);
+            return;
+        }
+        GLState::bindBuffer(GL_COPY_WRITE_BUFFER, ID);
+        if (GLAD_GL_VERSION_4_4 || GLAD_GL_ARB_buffer_storage)
+            glBufferStorage(GL_COPY_WRITE_BUFFER, size, data, flags);
+        else
+            glBufferData(GL_COPY_WRITE_BUFFER, size, data, (flags & GL_DYNAMIC_STORAGE_BIT) ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW);
+    }
+
+    // (Re)allocates mutable storage, orphaning the previous contents
+    void data(GLsizeiptr size, const void* data, GLenum usage)
+    {
+        TRACE_SCOPE("buffer upload");
+        if (directStateAccess())
+        {
+            glNamedBufferData(ID, size, data, usage);
+            return;
+        }
+        // the copy target leaves the array and element bindings alone, and stays
+        // bound so editing the same buffer again binds nothing
+        GLState::bindBuffer(GL_COPY_WRITE_BUFFER, ID);
+        glBufferData(GL_COPY_WRITE_BUFFER, size, data, usage);
+    }
+
+    void subData(GLintptr offset, GLsizeiptr size, const void* data)
+    {
+        TRACE_SCOPE("buffer upload");
+        if (directStateAccess())
+        {
+            glNamedBufferSubData(ID, offset, size, data);
+            return;
+        }
+        GLState::bindBuffer(GL_COPY_WRITE_BUFFER, ID);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, offset, size, data);
+    }
+
+    void* map(GLintptr offset, GLsizeiptr size, GLbitfield access)
+    {
+        if (directStateAccess())
+            return glMapNamedBufferRange(ID, offset, size, access);
+        GLState::bindBuffer(GL_COPY_WRITE_BUFFER, ID);
+        return glMapBufferRange(GL_COPY_WRITE_BUFFER, offset, size, access);
+    }
+
+    void unmap()
+    {
+        if (directStateAccess())
+        {
+            glUnmapNamedBuffer(ID);
+            return;
+        }
+        GLState::bindBuffer(GL_COPY_WRITE_BUFFER, ID);
+        glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+    }
+};
+
+class VertexArray
+{
+public:
+    unsigned int ID = 0;
+
+    VertexArray()
+    {
+        if (directStateAccess())
+            glCreateVertexArrays(1, &ID);
+        else
+            glGenVertexArrays(1, &ID);
+    }
+
+    VertexArray(const VertexArray&) = delete;
+    VertexArray& operator=(const VertexArray&) = delete;
+
+    VertexArray(VertexArray&& other) noexcept : ID(std::exchange(other.ID, 0)) {}
+
+    VertexArray& operator=(VertexArray&& other) noexcept
+    {
+        std::swap(ID, other.ID);
+        return *this;
+    }
+
+    ~VertexArray()
+    {
+        if (ID != 0)
+            GLState::deleteVertexArray(ID);
+    }
+
+    void bind() const
+    {
+        GLState::bindVertexArray(ID);
+    }
+
+    // Float attribute `index` read from `buffer`, one binding point per attribute
+    void attribute(GLuint index, GLuint buffer, GLint size, GLenum type, GLsizei stride, GLintptr offset = 0)
+    {
+        if (directStateAccess())
+        {
+            glVertexArrayVertexBuffer(ID, index, buffer, offset, stride);
+            glVertexArrayAttribFormat(ID, index, size, type, GL_FALSE, 0);
+            glVertexArrayAttribBinding(ID, index, index);
+            glEnableVertexArrayAttrib(ID, index);
+            return;
+        }
+        bind();
+        GLState::bindBuffer(GL_ARRAY_BUFFER, buffer);
+        glVertexAttribPointer(index, size, type, GL_FALSE, stride, (const void*)offset);
+        glEnableVertexAttribArray(index);
+    }
+
+    // Advances attribute `index` once every `divisor` instances instead of per vertex
+    void divisor(GLuint index, GLuint divisor)
+    {
+        if (directStateAccess())
+        {
+            glVertexArrayBindingDivisor(ID, index, divisor);
+            return;
+        }
+        bind();
+        glVertexAttribDivisor(index, divisor);
+    }
+
+    void elementBuffer(GLuint buffer)
+    {
+        if (directStateAccess())
+        {
+            glVertexArrayElementBuffer(ID, buffer);
+            return;
+        }
+        bind();
+        GLState::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer);
+    }
+};
+
+// A single-level 2D texture with nearest filtering, e.g. a render target or an image
+class Texture
+{
+public:
+    unsigned int ID = 0;
+
+    Texture()
+    {
+        if (directStateAccess())
+            glCreateTextures(GL_TEXTURE_2D, 1, &ID);
+        else
+            glGenTextures(1, &ID);
+    }
+
+    Texture(const Texture&) = delete;
+    Texture& operator=(const Texture&) = delete;
+
+    Texture(Texture&& other) noexcept : ID(std::exchange(other.ID, 0)) {}
+
+    Texture& operator=(Texture&& other) noexcept
+    {
+        std::swap(ID, other.ID);
+        return *this;
+    }
+
+    ~Texture()
+    {
+        if (ID != 0)
+            glDeleteTextures(1, &ID);
+    }
+
+    // Allocates the texels once, filled from data (in format and type) unless it is NULL
+    void storage(GLenum internalFormat, int width, int height, GLenum format, GLenum type, const void* data = NULL)
+    {
+        if (directStateAccess())
+        {
+            glTextureStorage2D(ID, 1, internalFormat, width, height);
+            if (data != NULL)
+                glTextureSubImage2D(ID, 0, 0, 0, width, height, format, type, data);
+            glTextureParameteri(ID, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTextureParameteri(ID, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            return;
+        }
+        glBindTexture(GL_TEXTURE_2D, ID);
+        glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, type, data);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+};
+
+class Renderbuffer
+{
+public:
+    unsigned int ID = 0;
+
+    Renderbuffer()
+    {
+        if (directStateAccess())
+            glCreateRenderbuffers(1, &ID);
+        else
+            glGenRenderbuffers(1, &ID);
+    }
+
+    Renderbuffer(const Renderbuffer&) = delete;
+    Renderbuffer& operator=(const Renderbuffer&) = delete;
+
+    Renderbuffer(Renderbuffer&& other) noexcept : ID(std::exchange(other.ID, 0)) {}
+
+    Renderbuffer& operator=(Renderbuffer&& other) noexcept
+    {
+        std::swap(ID, other.ID);
+        return *this;
+    }
+
+    ~Renderbuffer()
+    {
+        if (ID != 0)
+            glDeleteRenderbuffers(1, &ID);
+    }
+
+    // samples = 0 for a single-sampled renderbuffer
+    void storage(GLenum internalFormat, int width, int height, int samples = 0)
+    {
+        if (directStateAccess())
+        {
+            glNamedRenderbufferStorageMultisample(ID, samples, internalFormat, width, height);
+            return;
+        }
+        glBindRenderbuffer(GL_RENDERBUFFER, ID);
+        glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, internalFormat, width, height);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    }
+};
+
+// Without DSA, editing a framebuffer binds it to GL_FRAMEBUFFER; bind the one to
+// draw into afterwards
+class Framebuffer
+{
+public:
+    unsigned int ID = 0;
+
+    Framebuffer()
+    {
+        if (directStateAccess())
+            glCreateFramebuffers(1, &ID);
+        else
+            glGenFramebuffers(1, &ID);
+    }
+
+    Framebuffer(const Framebuffer&) = delete;
+    Framebuffer& operator=(const Framebuffer&) = delete;
+
+    Framebuffer(Framebuffer&& other) noexcept : ID(std::exchange(other.ID, 0)) {}
+
+    Framebuffer& operator=(Framebuffer&& other) noexcept
+    {
+        std::swap(ID, other.ID);
+        return *this;
+    }
+
+    ~Framebuffer()
+    {
+        if (ID != 0)
+            glDeleteFramebuffers(1, &ID);
+    }
+
+    void bind() const
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, ID);
+    }
+
+    void attach(GLenum attachment, const Renderbuffer& renderbuffer)
+    {
+        if (directStateAccess())
+        {
+            glNamedFramebufferRenderbuffer(ID, attachment, GL_RENDERBUFFER, renderbuffer.ID);
+            return;
+        }
+        bind();
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, attachment, GL_RENDERBUFFER, renderbuffer.ID);
+    }
+
+    void attach(GLenum attachment, const Texture& texture)
+    {
+        if (directStateAccess())
+        {
+            glNamedFramebufferTexture(ID, attachment, texture.ID, 0);
+            return;
+        }
+        bind();
+        glFramebufferTexture2D(GL_FRAMEBUFFER, attachment, GL_TEXTURE_2D, texture.ID, 0);
+    }
+
+    void drawBuffers(GLsizei count, const GLenum* buffers)
+    {
+        if (directStateAccess())
+        {
+            glNamedFramebufferDrawBuffers(ID, count, buffers);
+            return;
+        }
+        bind();
+        glDrawBuffers(count, buffers);
+    }
+
+    bool complete()
+    {
+        if (directStateAccess())
+            return glCheckNamedFramebufferStatus(ID, GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+        bind();
+        return glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    }
+};
+
+#endif  // GL_RESOURCES_H
@@ -0,0 +1,245 @@
+#ifndef GL_STATE_H
+#define GL_STATE_H
+
+#include <glad.h>
+
+#include <cstdint>
+#include <unordered_map>
+
+// GL state changes requested through GLState since the last resetCounters()
+struct GLStateCounters
+{
+    unsigned long issued = 0;       // reached the driver
+    unsigned long elided = 0;       // matched the shadowed state and were skipped
+};
+
+/**
+ * Shadow copy of the GL state the renderer changes: the bound program and vertex
+ * array, buffer bindings, capabilities (blending, depth test, program point size...),
+ * the blend function and the depth and color masks. A request that matches the
+ * shadow costs no GL call. State nobody has set yet is unknown, so the first
+ * request always reaches GL.
+ *
+ * It only stays correct if every change in the program goes through here. Deleting
+ * a bound object must go through the delete functions (or be reported with
+ * forget*()), since GL may hand out its name again.
+ *
+ * Element array bindings belong to the vertex array and are never elided.
+ */
+class GLState
+{
+public:
+    static void useProgram(unsigned int program)
+    {
+        if (!changes(currentProgram, program))
+            return;
+        glUseProgram(program);
+    }
+
+    static void bindVertexArray(unsigned int vertexArray)
+    {
+        if (!changes(currentVertexArray, vertexArray))
+            return;
+        glBindVertexArray(vertexArray);
+    }
+
+    static void bindBuffer(GLenum target, unsigned int buffer)
+    {
+        if (target == GL_ELEMENT_ARRAY_BUFFER)
+            counts.issued++;
+        else if (!changes(shadowOf(boundBuffers, target), buffer))
+            return;
+        glBindBuffer(target, buffer);
+    }
+
+    // Also binds the buffer to the generic target, as GL does
+    static void bindBufferBase(GLenum target, unsigned int index, unsigned int buffer)
+    {
+        bindBufferRange(target, index, buffer, 0, 0);
+    }
+
+    // size 0 binds the whole buffer
+    static void bindBufferRange(GLenum target, unsigned int index, unsigned int buffer,
+                                GLintptr offset, GLsizeiptr size)
+    {
+        shadowOf(boundBuffers, target) = buffer;
+        if (!changes(indexedBuffers[indexedKey(target, index)], IndexedBinding{buffer, offset, size}))
+            return;
+        if (size == 0)
+            glBindBufferBase(target, index, buffer);
+        else
+            glBindBufferRange(target, index, buffer, offset, size);
+    }
+
+    static void enable(GLenum capability)
+    {
+        if (!changes(shadowOf(capabilities, capability), 1u))
+            return;
+        glEnable(capability);
+    }
+
+    static void disable(GLenum capability)
+    {
+        if (!changes(shadowOf(capabilities, capability), 0u))
+            return;
+        glDisable(capability);
+    }
+
+    static void blendFunc(GLenum source, GLenum destination)
+    {
+        if (!changes(blendFunction, BlendFunction{source, destination, true}))
+            return;
+        glBlendFunc(source, destination);
+    }
+
+    // Per-draw-buffer blending is not shadowed; it leaves the global function unknown
+    static void blendFunci(GLuint buffer, GLenum source, GLenum destination)
+    {
+        counts.issued++;
+        blendFunction.known = false;
+        glBlendFunci(buffer, source, destination);
+    }
+
+    static void depthMask(GLboolean flag)
+    {
+        if (!changes(depthWrites, flag ? 1u : 0u))
+            return;
+        glDepthMask(flag);
+    }
+
+    static void colorMask(GLboolean red, GLboolean green, GLboolean blue, GLboolean alpha)
+    {
+        unsigned int mask = (red ? 1 : 0) | (green ? 2 : 0) | (blue ? 4 : 0) | (alpha ? 8 : 0);
+        if (!changes(colorWrites, mask))
+            return;
+        glColorMask(red, green, blue, alpha);
+    }
+
+    static void deleteVertexArray(unsigned int vertexArray)
+    {
+        forgetVertexArray(vertexArray);
+        glDeleteVertexArrays(1, &vertexArray);
+    }
+
+    static void deleteBuffers(GLsizei count, const unsigned int* buffers)
+    {
+        for (GLsizei i = 0; i < count; i++)
+            forgetBuffer(buffers[i]);
+        glDeleteBuffers(count, buffers);
+    }
+
+    // GL may hand a deleted object's name out again. A deleted program stays in
+    // use until the next glUseProgram, so its binding becomes unknown; deleted
+    // vertex arrays and buffers are unbound.
+    static void forgetProgram(unsigned int program)
+    {
+        if (program == currentProgram)
+            currentProgram = UNKNOWN;
+    }
+
+    static void forgetVertexArray(unsigned int vertexArray)
+    {
+        if (vertexArray == currentVertexArray)
+            currentVertexArray = 0;
+    }
+
+    static void forgetBuffer(unsigned int buffer)
+    {
+        for (auto& [target, bound] : boundBuffers)
+        {
+            if (bound == buffer)
+                bound = 0;
+        }
+        for (auto& [key, binding] : indexedBuffers)
+        {
+            if (binding.buffer == buffer)
+                binding = IndexedBinding();
+        }
+    }
+
+    // Forgets everything, e.g. after code outside the tracker changed state
+    static void invalidate()
+    {
+        currentProgram = UNKNOWN;
+        currentVertexArray = UNKNOWN;
+        boundBuffers.clear();
+        indexedBuffers.clear();
+        capabilities.clear();
+        blendFunction.known = false;
+        depthWrites = UNKNOWN;
+        colorWrites = UNKNOWN;
+    }
+
+    static const GLStateCounters& counters()
+    {
+        return counts;
+    }
+
+    static void resetCounters()
+    {
+        counts = GLStateCounters();
+    }
+
+private:
+    static constexpr unsigned int UNKNOWN = 0xFFFFFFFF;
+
+    struct IndexedBinding
+    {
+        unsigned int buffer = UNKNOWN;
+        GLintptr offset = 0;
+        GLsizeiptr size = 0;
+
+        bool operator==(const IndexedBinding& other) const
+        {
+            return buffer == other.buffer && offset == other.offset && size == other.size;
+        }
+    };
+
+    struct BlendFunction
+    {
+        GLenum source, destination;
+        bool known;
+
+        bool operator==(const BlendFunction& other) const
+        {
+            return known && other.known && source == other.source && destination == other.destination;
+        }
+    };
+
+    static inline GLStateCounters counts;
+    static inline unsigned int currentProgram = UNKNOWN;
+    static inline unsigned int currentVertexArray = UNKNOWN;
+    static inline std::unordered_map<GLenum, unsigned int> boundBuffers;
+    static inline std::unordered_map<uint64_t, IndexedBinding> indexedBuffers;
+    static inline std::unordered_map<GLenum, unsigned int> capabilities;    // 0, 1 or UNKNOWN
+    static inline BlendFunction blendFunction = {GL_ONE, GL_ZERO, false};
+    static inline unsigned int depthWrites = UNKNOWN;
+    static inline unsigned int colorWrites = UNKNOWN;
+
+    // Records the new value and counts the call; false when it is already set
+    template <typename T>
+    static bool changes(T& shadow, const T& value)
+    {
+        if (shadow == value)
+        {
+            counts.elided++;
+            return false;
+        }
+        shadow = value;
+        counts.issued++;
+        return true;
+    }
+
+    // entries nobody has set yet read as unknown
+    static unsigned int& shadowOf(std::unordered_map<GLenum, unsigned int>& map, GLenum key)
+    {
+        return map.try_emplace(key, UNKNOWN).first->second;
+    }
+
+    static uint64_t indexedKey(GLenum target, unsigned int index)
+    {
+        return (uint64_t)target << 32 | index;
+    }
+};
+
+#endif  // GL_STATE_H
@@ -0,0 +1,82 @@
+#ifndef GPU_CULLING_H
+#define GPU_CULLING_H
+
+#include <glad.h>
+
+#include <gl_resources.h>
+#include <instanced_renderer.h>
+#include <shader.h>
+
+// Shader storage bindings used by cull_compute.glsl
+const unsigned int CULL_INSTANCES_BINDING = 0;
+const unsigned int CULL_COMMANDS_BINDING = 1;
+
+// Matches the GL DrawArraysIndirectCommand layout
+struct DrawArraysIndirectCommand
+{
+    unsigned int count;
+    unsigned int instanceCount;
+    unsigned int first;
+    unsigned int baseInstance;
+};
+
+/**
+ * GPU-driven drawing of the spheres held by an InstancedRenderer (GL 4.3).
+ *
+ * A compute pass frustum-culls every instance against the projection in the
+ * FrameConstants block and picks how many progressive points to draw from the
+ * sphere's projected size. It writes one DrawArraysIndirectCommand per instance,
+ * with a count of zero for culled spheres, and a single glMultiDrawArraysIndirect
+ * consumes them. The CPU never touches individual spheres.
+ */
+class CulledRenderer
+{
+public:
+    Buffer commandBuffer;
+
+    CulledRenderer(InstancedRenderer& spheres, Shader&& cullShader, float sphereRadius)
+        : spheres(spheres), cullShader(std::move(cullShader)), sphereRadius(sphereRadius), capacity(0)
+    {
+    }
+
+    // compute shaders, SSBOs and multi-draw-indirect are all core in 4.3
+    static bool supported()
+    {
+        return GLAD_GL_VERSION_4_3;
+    }
+
+    void draw(Shader& shader)
+    {
+        int count = spheres.numInstances;
+        if (count == 0)
+            return;
+        if (count > capacity)
+        {
+            commandBuffer.data(sizeof(DrawArraysIndirectCommand) * count, NULL, GL_DYNAMIC_DRAW);
+            capacity = count;
+        }
+
+        // 1. cull and pick a LOD per instance
+        cullShader.use();
+        cullShader.setUint("instanceCount", (unsigned int)count);
+        cullShader.setFloat("sphereRadius", sphereRadius);
+        GLState::bindBufferBase(GL_SHADER_STORAGE_BUFFER, CULL_INSTANCES_BINDING, spheres.instanceBuffer.ID);
+        GLState::bindBufferBase(GL_SHADER_STORAGE_BUFFER, CULL_COMMANDS_BINDING, commandBuffer.ID);
+        glDispatchCompute((count + 63) / 64, 1, 1);
+
+        // 2. draw whatever survived, reading the commands written above
+        glMemoryBarrier(GL_COMMAND_BARRIER_BIT);
+        shader.use();
+        spheres.vertexArray.bind();
+        GLState::bindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer.ID);
+        glMultiDrawArraysIndirect(GL_POINTS, NULL, count, 0);
+    }
+
+private:
+    InstancedRenderer& spheres;
+    Program cullShader;
+    float sphereRadius;
+    int capacity;
+};
+
+#endif  // GPU_CULLING_H
@@ -0,0 +1,170 @@
+#ifndef GPU_SORT_H
+#define GPU_SORT_H
+
+#include <glad.h>
+
+#include <string>
+#include <vector>
+
+#include <gl_resources.h>
+#include <shader.h>
+
+#include <filesystem>
+namespace fs = std::filesystem;
+
+// Mirrors src/shaders/radix_sort.glsl
+const int SORT_RADIX_BITS = 4;
+const int SORT_RADIX_SIZE = 1 << SORT_RADIX_BITS;     // digits per pass
+const int SORT_BLOCK_SIZE = 1024;       // keys per workgroup of the block kernels
+const int SORT_THREADS = 256;
+const unsigned int SORT_MAX_GROUPS_X = 65535;     // the guaranteed GL_MAX_COMPUTE_WORK_GROUP_COUNT
+
+/**
+ * Back-to-front point order computed on the GPU (GL 4.3).
+ *
+ * Every frame, sort() builds the same 32-bit keys as depthSortCPU() from the
+ * rotation in the FrameConstants block, then runs a stable LSD radix sort over
+ * 4-bit digits: per pass, one kernel counts each block's digits, a multi-level
+ * prefix scan turns the counts into output offsets and a scatter kernel moves
+ * the keys. The sorted point indices never leave the GPU; bind indexBuffer() as
+ * the element array buffer and draw with glDrawElements. The output equals
+ * depthSortCPU()'s, which serves as the reference.
+ */
+class GpuDepthSorter
+{
+public:
+    GpuDepthSorter(const fs::path& shaderDir)
+        : keysShader(Shader::compute((shaderDir / "sort_keys_compute.glsl").string())),
+          countShader(Shader::compute((shaderDir / "sort_count_compute.glsl").string())),
+          scatterShader(Shader::compute((shaderDir / "sort_scatter_compute.glsl").string())),
+          scanShader(Shader::compute((shaderDir / "scan_compute.glsl").string())),
+          scanAddShader(Shader::compute((shaderDir / "scan_add_compute.glsl").string())),
+          capacity(0)
+    {
+    }
+
+    static bool supported()
+    {
+        return GLAD_GL_VERSION_4_3;
+    }
+
+    /**
+     * Sorts the points of positionBuffer (tightly packed vec3) by increasing
+     * rotated z. The FrameConstants block must already hold this frame's rotation.
+     */
+    void sort(unsigned int positionBuffer, int count)
+    {
+        if (count <= 0)
+            return;
+        reserve(count);
+        unsigned int blocks = (unsigned int)((count + SORT_BLOCK_SIZE - 1) / SORT_BLOCK_SIZE);
+
+        keysShader.use();
+        keysShader.setUint("count", (unsigned int)count);
+        GLState::bindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, positionBuffer);
+        GLState::bindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, keys[0].ID);
+        GLState::bindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, values[0].ID);
+        dispatch((count + SORT_THREADS - 1) / SORT_THREADS);
+
+        // an even number of passes leaves the result in keys[0] / values[0]
+        for (unsigned int shift = 0, pass = 0; shift < 32; shift += SORT_RADIX_BITS, pass++)
+        {
+            int in = pass % 2, out = 1 - in;
+            glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+            countShader.use();
+            countShader.setUint("count", (unsigned int)count);
+            countShader.setUint("shift", shift);
+            countShader.setUint("numBlocks", blocks);
+            GLState::bindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, keys[in].ID);
+            GLState::bindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, blockOffsets.ID);
+            dispatch(blocks);
+
+            glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+            scan(blockOffsets.ID, blocks * SORT_RADIX_SIZE, 0);
+
+            glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+            scatterShader.use();
+            scatterShader.setUint("count", (unsigned int)count);
+            scatterShader.setUint("shift", shift);
+            scatterShader.setUint("numBlocks", blocks);
+            GLState::bindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, keys[in].ID);
+            GLState::bindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, values[in].ID);
+            GLState::bindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, blockOffsets.ID);
+            GLState::bindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, keys[out].ID);
+            GLState::bindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, values[out].ID);
+            dispatch(blocks);
+        }
+        glMemoryBarrier(GL_ELEMENT_ARRAY_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+    }
+
+    // Sorted point indices (GL_UNSIGNED_INT), valid after sort(). The buffer exists
+    // from construction on, so it can be attached to a vertex array before the first sort
+    unsigned int indexBuffer() const
+    {
+        return values[0].ID;
+    }
+
+private:
+    Program keysShader, countShader, scatterShader, scanShader, scanAddShader;
+    Buffer keys[2], values[2];
+    Buffer blockOffsets;
+    std::vector<Buffer> scanSums;       // block totals, one buffer per scan level
+    int capacity;
+
+    // runs groups workgroups, in rows of at most SORT_MAX_GROUPS_X; the shaders number them with workGroupIndex()
+    static void dispatch(unsigned int groups)
+    {
+        unsigned int rows = (groups + SORT_MAX_GROUPS_X - 1) / SORT_MAX_GROUPS_X;
+        glDispatchCompute(rows > 1 ? SORT_MAX_GROUPS_X : groups, rows, 1);
+    }
+
+    // grows the buffers to hold count keys; they are never shrunk
+    void reserve(int count)
+    {
+        if (count <= capacity)
+            return;
+        capacity = count;
+        GLsizeiptr blocks = (count + SORT_BLOCK_SIZE - 1) / SORT_BLOCK_SIZE;
+        for (int i = 0; i < 2; i++)
+        {
+            keys[i].data(sizeof(unsigned int) * count, NULL, GL_DYNAMIC_COPY);
+            values[i].data(sizeof(unsigned int) * count, NULL, GL_DYNAMIC_COPY);
+        }
+        blockOffsets.data(sizeof(unsigned int) * blocks * SORT_RADIX_SIZE, NULL, GL_DYNAMIC_COPY);
+
+        // each scan level leaves one total per block for the next
+        scanSums.clear();
+        GLsizeiptr levelCount = blocks * SORT_RADIX_SIZE;
+        do
+        {
+            levelCount = (levelCount + SORT_BLOCK_SIZE - 1) / SORT_BLOCK_SIZE;
+            scanSums.emplace_back();
+            scanSums.back().data(sizeof(unsigned int) * levelCount, NULL, GL_DYNAMIC_COPY);
+        } while (levelCount > 1);
+    }
+
+    // exclusive prefix sum of count uints in buffer, in place
+    void scan(unsigned int buffer, unsigned int count, size_t level)
+    {
+        unsigned int blocks = (count + SORT_BLOCK_SIZE - 1) / SORT_BLOCK_SIZE;
+        scanShader.use();
+        scanShader.setUint("count", count);
+        GLState::bindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, buffer);
+        GLState::bindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, scanSums[level].ID);
+        dispatch(blocks);
+        if (blocks == 1)
+            return;
+
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+        scan(scanSums[level].ID, blocks, level + 1);
+
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+        scanAddShader.use();
+        scanAddShader.setUint("count", count);
+        GLState::bindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, buffer);
+        GLState::bindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, scanSums[level].ID);
+        dispatch(blocks);
+    }
+};
+
+#endif  // GPU_SORT_H
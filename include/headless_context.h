@@ -0,0 +1,247 @@
+#ifndef HEADLESS_CONTEXT_H
+#define HEADLESS_CONTEXT_H
+
+#include <glad.h>
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <gl_state.h>
+
+/**
+ * GL context without a display, for render servers and CI. The context comes from
+ * EGL, preferring Mesa's surfaceless platform (llvmpipe renders without a GPU or
+ * X server), and draws into an offscreen framebuffer of the given size instead of
+ * a window. With samples > 0 the framebuffer is multisampled and resolved when
+ * the pixels are read back.
+ *
+ * Construct, check valid(), load GL with getProcAddress, then call createFramebuffer().
+ */
+class HeadlessContext
+{
+public:
+    int width, height;
+
+    HeadlessContext(int width, int height, int samples = 0)
+        : width(width), height(height), samples(samples)
+    {
+        display = openDisplay();
+        EGLint major, minor;
+        if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor))
+        {
+            std::cerr << "ERROR::HEADLESS::NO_EGL_DISPLAY" << std::endl;
+            display = EGL_NO_DISPLAY;
+            return;
+        }
+
+        const EGLint configAttributes[] = {
+            EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+            EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+            EGL_NONE
+        };
+        EGLConfig config;
+        EGLint configs = 0;
+        const EGLint contextAttributes[] = {
+            EGL_CONTEXT_MAJOR_VERSION, 3,
+            EGL_CONTEXT_MINOR_VERSION, 3,
+            EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+            EGL_NONE
+        };
+        if (!eglBindAPI(EGL_OPENGL_API)
+            || !eglChooseConfig(display, configAttributes, &config, 1, &configs) || configs == 0
+            || (context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttributes)) == EGL_NO_CONTEXT)
+        {
+            std::cerr << "ERROR::HEADLESS::NO_GL_CONTEXT\n" << "EGL error 0x" << std::hex << eglGetError() << std::dec << std::endl;
+            return;
+        }
+
+        // rendering only ever goes to our framebuffer, but without
+        // EGL_KHR_surfaceless_context the context still needs a surface
+        const char* extensions = eglQueryString(display, EGL_EXTENSIONS);
+        if (!hasExtension(extensions, "EGL_KHR_surfaceless_context"))
+        {
+            const EGLint surfaceAttributes[] = {EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE};
+            surface = eglCreatePbufferSurface(display, config, surfaceAttributes);
+        }
+        current = eglMakeCurrent(display, surface, surface, context);
+        if (!current)
+            std::cerr << "ERROR::HEADLESS::MAKE_CURRENT_FAILED" << std::endl;
+    }
+
+    bool valid() const
+    {
+        return current;
+    }
+
+    // For gladLoadGLLoader
+    static void* getProcAddress(const char* name)
+    {
+        return (void*)eglGetProcAddress(name);
+    }
+
+    // Creates the offscreen framebuffer and binds it; needs GL to be loaded
+    void createFramebuffer()
+    {
+        glGenFramebuffers(1, &renderFramebuffer);
+        glGenRenderbuffers(2, renderbuffers);
+        glBindFramebuffer(GL_FRAMEBUFFER, renderFramebuffer);
+        glBindRenderbuffer(GL_RENDERBUFFER, renderbuffers[0]);
+        glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_RGBA8, width, height);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, renderbuffers[0]);
+        glBindRenderbuffer(GL_RENDERBUFFER, renderbuffers[1]);
+        glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_DEPTH_COMPONENT24, width, height);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, renderbuffers[1]);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cerr << "ERROR::HEADLESS::FRAMEBUFFER_INCOMPLETE" << std::endl;
+
+        // multisampled pixels are resolved into a plain framebuffer before reading
+        if (samples > 0)
+        {
+            glGenFramebuffers(1, &resolveFramebuffer);
+            glGenRenderbuffers(1, &resolveRenderbuffer);
+            glBindFramebuffer(GL_FRAMEBUFFER, resolveFramebuffer);
+            glBindRenderbuffer(GL_RENDERBUFFER, resolveRenderbuffer);
+            glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+            glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, resolveRenderbuffer);
+            glBindFramebuffer(GL_FRAMEBUFFER, renderFramebuffer);
+        }
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    }
+
+    // The same at a size only known once GL is loaded, such as poster tiles
+    void createFramebuffer(int width, int height)
+    {
+        this->width = width;
+        this->height = height;
+        createFramebuffer();
+    }
+
+    // What the renderer draws into in place of the default framebuffer
+    unsigned int framebuffer() const
+    {
+        return renderFramebuffer;
+    }
+
+    // A framebuffer holding the last frame that glReadPixels can read, resolving
+    // the multisampled one first
+    unsigned int readableFramebuffer()
+    {
+        if (samples == 0)
+            return renderFramebuffer;
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, renderFramebuffer);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, resolveFramebuffer);
+        glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, renderFramebuffer);
+        return resolveFramebuffer;
+    }
+
+    // Tightly packed RGB pixels of part of the last frame, bottom row first
+    void readPixels(int x, int y, int regionWidth, int regionHeight, unsigned char* rgb)
+    {
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, readableFramebuffer());
+        // pixel pack buffers would turn the pointer into an offset
+        GLState::bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glReadPixels(x, y, regionWidth, regionHeight, GL_RGB, GL_UNSIGNED_BYTE, rgb);
+        glBindFramebuffer(GL_FRAMEBUFFER, renderFramebuffer);
+    }
+
+    // RGB pixels of the last frame, top row first
+    std::vector<unsigned char> readPixels()
+    {
+        std::vector<unsigned char> rows((size_t)width * height * 3);
+        readPixels(0, 0, width, height, rows.data());
+
+        // GL returns the bottom row first
+        std::vector<unsigned char> pixels(rows.size());
+        const size_t stride = (size_t)width * 3;
+        for (int y = 0; y < height; y++)
+            memcpy(&pixels[y * stride], &rows[(height - 1 - y) * stride], stride);
+        return pixels;
+    }
+
+    // Writes the last frame as a binary PPM
+    bool writePPM(const std::string& path)
+    {
+        std::vector<unsigned char> pixels = readPixels();
+        FILE* file = fopen(path.c_str(), "wb");
+        if (file == NULL)
+        {
+            std::cerr << "ERROR::HEADLESS::CANNOT_WRITE " << path << std::endl;
+            return false;
+        }
+        fprintf(file, "P6\n%d %d\n255\n", width, height);
+        bool written = fwrite(pixels.data(), 1, pixels.size(), file) == pixels.size();
+        return fclose(file) == 0 && written;
+    }
+
+    void terminate()
+    {
+        if (current)
+        {
+            glDeleteFramebuffers(1, &renderFramebuffer);
+            glDeleteRenderbuffers(2, renderbuffers);
+            if (samples > 0)
+            {
+                glDeleteFramebuffers(1, &resolveFramebuffer);
+                glDeleteRenderbuffers(1, &resolveRenderbuffer);
+            }
+            eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+            current = false;
+        }
+        if (surface != EGL_NO_SURFACE)
+            eglDestroySurface(display, surface);
+        if (context != EGL_NO_CONTEXT)
+            eglDestroyContext(display, context);
+        if (display != EGL_NO_DISPLAY)
+            eglTerminate(display);
+        surface = EGL_NO_SURFACE;
+        context = EGL_NO_CONTEXT;
+        display = EGL_NO_DISPLAY;
+    }
+
+private:
+    int samples;
+    EGLDisplay display = EGL_NO_DISPLAY;
+    EGLContext context = EGL_NO_CONTEXT;
+    EGLSurface surface = EGL_NO_SURFACE;
+    bool current = false;
+    unsigned int renderFramebuffer = 0, resolveFramebuffer = 0;
+    unsigned int renderbuffers[2] = {0, 0};
+    unsigned int resolveRenderbuffer = 0;
+
+    static bool hasExtension(const char* extensions, const char* name)
+    {
+        if (extensions == NULL)
+            return false;
+        const size_t length = strlen(name);
+        for (const char* found = strstr(extensions, name); found != NULL; found = strstr(found + length, name))
+        {
+            if ((found == extensions || found[-1] == ' ') && (found[length] == ' ' || found[length] == '\0'))
+                return true;
+        }
+        return false;
+    }
+
+    // The surfaceless platform needs no window system at all; other EGL
+    // implementations get their default display
+    static EGLDisplay openDisplay()
+    {
+        const char* clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+        if (hasExtension(clientExtensions, "EGL_MESA_platform_surfaceless"))
+        {
+            auto getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+            if (getPlatformDisplay != NULL)
+                return getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+        }
+        return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    }
+};
+
+#endif  // HEADLESS_CONTEXT_H
@@ -0,0 +1,161 @@
+#ifndef HEMISPHERE_CULLING_H
+#define HEMISPHERE_CULLING_H
+
+#include <glad.h>
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include <generator.h>
+
+/**
+ * Skips the back hemisphere of a point sphere before the vertex shader runs.
+ *
+ * The constructor sorts the points into patches: each point goes to the cube face
+ * its direction points at, then to a cell of a grid on that face. Every patch is
+ * a contiguous range with a bounding cone. Once per frame, visibleRanges() tests
+ * the cones against the view direction in model space (the third row of the
+ * rotation). Only patches that can reach in front of the cut plane are drawn,
+ * through glMultiDrawArrays. The vertex shader's BACK_CULL_Z test then trims the
+ * patches that straddle the cut.
+ */
+class HemisphereCuller
+{
+public:
+    struct Patch
+    {
+        int first, count;
+        glm::vec3 axis;         // unit direction of the cone's center
+        float sinAngle;         // sin and cos of the cone's half-angle
+        float cosAngle;
+        float radius;           // largest distance of a point from the center
+    };
+
+    std::vector<Patch> patches;
+
+    // Reorders points in place; cellsPerEdge^2 patches are made on each cube face
+    HemisphereCuller(vec3local* points, int count, int cellsPerEdge = 8)
+    {
+        std::vector<int> keys(count);
+        std::vector<int> bucketSizes(6 * cellsPerEdge * cellsPerEdge + 1, 0);
+        for (int i = 0; i < count; i++)
+        {
+            keys[i] = patchKey(points[i], cellsPerEdge);
+            bucketSizes[keys[i] + 1]++;
+        }
+
+        // counting sort keeps the spiral order inside each patch
+        for (size_t b = 1; b < bucketSizes.size(); b++)
+            bucketSizes[b] += bucketSizes[b - 1];
+        std::vector<vec3local> sorted(count);
+        std::vector<int> next(bucketSizes.begin(), bucketSizes.end() - 1);
+        for (int i = 0; i < count; i++)
+            sorted[next[keys[i]]++] = points[i];
+        std::copy(sorted.begin(), sorted.end(), points);
+
+        for (size_t b = 0; b + 1 < bucketSizes.size(); b++)
+        {
+            int first = bucketSizes[b];
+            int size = bucketSizes[b + 1] - first;
+            if (size > 0)
+                patches.push_back(boundingCone(points, first, size));
+        }
+    }
+
+    /**
+     * Appends the ranges of patches with a point whose rotated z can reach cullZ,
+     * merging neighbouring ranges. The results feed glMultiDrawArrays directly.
+     */
+    void visibleRanges(const glm::mat4& rotation, float cullZ,
+                       std::vector<GLint>& firsts, std::vector<GLsizei>& counts) const
+    {
+        // rotated z of p is dot(p, view); view is the third row of the rotation
+        glm::vec3 view = glm::normalize(glm::vec3(rotation[0][2], rotation[1][2], rotation[2][2]));
+        firsts.clear();
+        counts.clear();
+        for (const Patch& patch : patches)
+        {
+            if (maxDot(patch, view) < cullZ)
+                continue;
+            if (!firsts.empty() && firsts.back() + counts.back() == patch.first)
+                counts.back() += patch.count;
+            else
+            {
+                firsts.push_back(patch.first);
+                counts.push_back(patch.count);
+            }
+        }
+    }
+
+private:
+    // cube face (0-5) and grid cell of the point's direction
+    static int patchKey(const vec3local& p, int cellsPerEdge)
+    {
+        float ax = std::fabs(p.x), ay = std::fabs(p.y), az = std::fabs(p.z);
+        int face;
+        float u, v, major;
+        if (ax >= ay && ax >= az)
+        {
+            face = p.x > 0 ? 0 : 1;
+            major = ax; u = p.y; v = p.z;
+        }
+        else if (ay >= az)
+        {
+            face = p.y > 0 ? 2 : 3;
+            major = ay; u = p.x; v = p.z;
+        }
+        else
+        {
+            face = p.z > 0 ? 4 : 5;
+            major = az; u = p.x; v = p.y;
+        }
+        if (!(major > 0.0f))
+            return 0;
+        int cu = std::clamp((int)((u / major * 0.5f + 0.5f) * cellsPerEdge), 0, cellsPerEdge - 1);
+        int cv = std::clamp((int)((v / major * 0.5f + 0.5f) * cellsPerEdge), 0, cellsPerEdge - 1);
+        return (face * cellsPerEdge + cu) * cellsPerEdge + cv;
+    }
+
+    static Patch boundingCone(const vec3local* points, int first, int count)
+    {
+        glm::vec3 sum(0.0f);
+        float radius = 0.0f;
+        for (int i = first; i < first + count; i++)
+        {
+            glm::vec3 p(points[i].x, points[i].y, points[i].z);
+            float length = glm::length(p);
+            radius = std::max(radius, length);
+            if (length > 0.0f)
+                sum += p / length;
+        }
+        glm::vec3 axis = glm::length(sum) > 0.0f ? glm::normalize(sum) : glm::vec3(0.0f, 0.0f, 1.0f);
+
+        float cosAngle = 1.0f;
+        for (int i = first; i < first + count; i++)
+        {
+            glm::vec3 p(points[i].x, points[i].y, points[i].z);
+            float length = glm::length(p);
+            if (length > 0.0f)
+                cosAngle = std::min(cosAngle, glm::dot(axis, p / length));
+        }
+        cosAngle = std::max(-1.0f, cosAngle);
+        return Patch{first, count, axis, std::sqrt(1.0f - cosAngle * cosAngle), cosAngle, radius};
+    }
+
+    // upper bound of dot(p, view) over the points of a patch
+    static float maxDot(const Patch& patch, const glm::vec3& view)
+    {
+        float cosTheta = glm::dot(patch.axis, view);
+        // view lies inside the cone: some direction in it points straight at the viewer
+        if (cosTheta >= patch.cosAngle)
+            return patch.radius;
+        // otherwise the closest direction is on the cone's rim: cos(theta - angle)
+        float sinTheta = std::sqrt(std::max(0.0f, 1.0f - cosTheta * cosTheta));
+        return patch.radius * (cosTheta * patch.cosAngle + sinTheta * patch.sinAngle);
+    }
+};
+
+#endif  // HEMISPHERE_CULLING_H
@@ -0,0 +1,140 @@
+#ifndef INSTANCED_RENDERER_H
+#define INSTANCED_RENDERER_H
+
+#include <glad.h>
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <random>
+#include <vector>
+
+#include <generator.h>
+#include <gl_resources.h>
+#include <rotation_state.h>
+#include <shader.h>
+
+// Per-instance attributes read by instanced_vertex.glsl (locations 1-4)
+struct SphereInstance
+{
+    glm::vec4 positionScale;    // xyz = center, w = scale
+    glm::vec4 orientation;      // quaternion (x, y, z, w)
+    glm::vec4 color;
+    float lod;                  // number of points drawn, at most the sphere's point count
+    float padding[3];
+};
+
+/**
+ * Draws many point spheres with a single glDrawArraysInstanced call.
+ *
+ * The unit sphere lives in one vertex buffer, stored in progressive order (see
+ * progressiveOrder()) so each instance's LOD draws a prefix that still covers the
+ * whole sphere. Transforms, colors and LODs come from a per-instance buffer that
+ * is only re-uploaded when setInstances() is called, so the per-frame CPU cost is
+ * one draw call no matter how many spheres there are.
+ */
+class InstancedRenderer
+{
+public:
+    VertexArray vertexArray;
+    Buffer pointBuffer, instanceBuffer;
+    int numPoints;
+    int numInstances;
+
+    InstancedRenderer(const vec3local* points, int count)
+        : numPoints(count), numInstances(0)
+    {
+        std::vector<vec3local> ordered(points, points + count);
+        progressiveOrder(ordered.data(), count);
+
+        pointBuffer.storage(sizeof(vec3local) * count, ordered.data());
+        vertexArray.attribute(0, pointBuffer.ID, 3, GL_FLOAT, sizeof(vec3local));
+
+        // one SphereInstance per instance rather than per vertex
+        const GLsizei stride = sizeof(SphereInstance);
+        vertexArray.attribute(1, instanceBuffer.ID, 4, GL_FLOAT, stride, offsetof(SphereInstance, positionScale));
+        vertexArray.attribute(2, instanceBuffer.ID, 4, GL_FLOAT, stride, offsetof(SphereInstance, orientation));
+        vertexArray.attribute(3, instanceBuffer.ID, 4, GL_FLOAT, stride, offsetof(SphereInstance, color));
+        vertexArray.attribute(4, instanceBuffer.ID, 1, GL_FLOAT, stride, offsetof(SphereInstance, lod));
+        for (unsigned int location = 1; location <= 4; location++)
+            vertexArray.divisor(location, 1);
+    }
+
+    // replaces the instance buffer; the only per-instance CPU work unless the spheres turn
+    void setInstances(const SphereInstance* instances, int count)
+    {
+        numInstances = count;
+        this->instances.assign(instances, instances + count);
+        instanceBuffer.data(sizeof(SphereInstance) * count, instances, GL_DYNAMIC_DRAW);
+    }
+
+    // rewrites every instance's orientation, one per rotation, e.g. each frame for turning spheres
+    void setOrientations(const RotationBatch& rotations)
+    {
+        for (int i = 0; i < numInstances && i < (int)rotations.size(); i++)
+        {
+            glm::quat orientation = rotations.orientation(i);
+            instances[i].orientation = glm::vec4(orientation.x, orientation.y, orientation.z, orientation.w);
+        }
+        instanceBuffer.subData(0, sizeof(SphereInstance) * numInstances, instances.data());
+    }
+
+    void draw(Shader& shader)
+    {
+        if (numInstances == 0)
+            return;
+        shader.use();
+        vertexArray.bind();
+        glDrawArraysInstanced(GL_POINTS, 0, numPoints, numInstances);
+    }
+
+    // the spheres of grid() turning at the given speed, each about its own random axis
+    static RotationBatch spin(const std::vector<SphereInstance>& instances, float speed)
+    {
+        RotationBatch rotations;
+        std::mt19937 gen(2);
+        std::normal_distribution<float> normal(0.0f, 1.0f);
+        for (const SphereInstance& instance : instances)
+        {
+            glm::vec3 axis = glm::normalize(glm::vec3(normal(gen), normal(gen), normal(gen)));
+            const glm::vec4& q = instance.orientation;
+            rotations.add(glm::quat(q.w, q.x, q.y, q.z), axis * speed);
+        }
+        return rotations;
+    }
+
+    /**
+     * Lays out count spheres on a square grid filling clip space. Each sphere gets
+     * a random orientation and color, and a LOD proportional to its on-screen size.
+     */
+    static std::vector<SphereInstance> grid(int count, int maxPoints)
+    {
+        std::vector<SphereInstance> instances(count);
+        int columns = (int)std::ceil(std::sqrt((double)count));
+        float cell = 2.0f / columns;
+        std::mt19937 gen(1);
+        std::uniform_real_distribution<float> dis(0.0f, 1.0f);
+        std::normal_distribution<float> normal(0.0f, 1.0f);
+        for (int i = 0; i < count; i++)
+        {
+            SphereInstance& instance = instances[i];
+            float x = -1.0f + cell * (i % columns + 0.5f);
+            float y = 1.0f - cell * (i / columns + 0.5f);
+            instance.positionScale = glm::vec4(x, y, 0.0f, cell * 0.5f);
+            instance.orientation = glm::normalize(glm::vec4(normal(gen), normal(gen), normal(gen), normal(gen)));
+            instance.color = glm::vec4(0.4f + 0.6f * dis(gen), 0.4f + 0.6f * dis(gen), 0.4f + 0.6f * dis(gen), 1.0f);
+            // a sphere a tenth of the screen wide does not need every point
+            float lod = maxPoints * std::min(1.0f, cell * cell * 4.0f);
+            instance.lod = std::max(64.0f, std::min((float)maxPoints, lod));
+            instance.padding[0] = instance.padding[1] = instance.padding[2] = 0.0f;
+        }
+        return instances;
+    }
+
+private:
+    std::vector<SphereInstance> instances;      // what the instance buffer holds
+};
+
+#endif  // INSTANCED_RENDERER_H
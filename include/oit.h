@@ -0,0 +1,247 @@
+#ifndef OIT_H
+#define OIT_H
+
+#include <glad.h>
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <gl_resources.h>
+#include <shader.h>
+
+#include <filesystem>
+namespace fs = std::filesystem;
+
+// How translucent points are composited
+enum TransparencyMode
+{
+    TRANSPARENCY_NONE = 0,          // draw order decides, see depth_sort.h
+    TRANSPARENCY_WEIGHTED = 1,      // weighted blended OIT, GL 4.0
+    TRANSPARENCY_LINKED_LIST = 2,   // exact per-pixel linked lists, GL 4.3
+};
+
+inline const char* transparencyModeName(TransparencyMode mode) {
+    switch (mode) {
+        case TRANSPARENCY_NONE:         return "none";
+        case TRANSPARENCY_WEIGHTED:     return "weighted";
+        case TRANSPARENCY_LINKED_LIST:  return "linked-list";
+    }
+    return "unknown";
+} /* transparencyModeName() */
+
+/**
+ * Weighted blended order-independent transparency (McGuire & Bavoil 2013).
+ *
+ * Points are drawn once, in any order, into an RGBA16F accumulation target and an
+ * R16F revealage target, with additive and multiplicative blending respectively.
+ * A full-screen pass then composites the weighted average over the framebuffer.
+ * Extra memory is fixed at 10 bytes per pixel.
+ */
+class WeightedBlendedOIT
+{
+public:
+    WeightedBlendedOIT(const fs::path& shaderDir, const std::vector<ShaderConstant>& constants)
+        : pointShader(Shader((shaderDir / "vertex.glsl").string(), (shaderDir / "oit_weighted_fragment.glsl").string(), constants)),
+          compositeShader(Shader((shaderDir / "fullscreen_vertex.glsl").string(), (shaderDir / "oit_composite_fragment.glsl").string())),
+          width(0), height(0)
+    {
+        compositeShader.use();
+        compositeShader.setInt("accumulationTexture", 0);
+        compositeShader.setInt("revealageTexture", 1);
+    }
+
+    // per-target blend functions need GL 4.0 (or ARB_draw_buffers_blend)
+    static bool supported()
+    {
+        return GLAD_GL_VERSION_4_0 || GLAD_GL_ARB_draw_buffers_blend;
+    }
+
+    // The program points must be drawn with between begin() and end()
+    Shader& shader()
+    {
+        return pointShader;
+    }
+
+    // Clears the targets and sets the accumulation blend state; reallocates on resize
+    void begin(int viewportWidth, int viewportHeight)
+    {
+        if (viewportWidth != width || viewportHeight != height)
+            allocate(viewportWidth, viewportHeight);
+
+        framebuffer.bind();
+        glViewport(0, 0, width, height);
+        const float clearAccumulation[] = {0.0f, 0.0f, 0.0f, 0.0f};
+        const float clearRevealage[] = {1.0f, 0.0f, 0.0f, 0.0f};
+        glClearBufferfv(GL_COLOR, 0, clearAccumulation);
+        glClearBufferfv(GL_COLOR, 1, clearRevealage);
+
+        GLState::disable(GL_DEPTH_TEST);
+        GLState::enable(GL_BLEND);
+        GLState::blendFunci(0, GL_ONE, GL_ONE);
+        GLState::blendFunci(1, GL_ZERO, GL_ONE_MINUS_SRC_COLOR);
+        pointShader.use();
+    }
+
+    // Composites the result over the given framebuffer and viewport
+    void end(unsigned int target, int x, int y)
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, target);
+        glViewport(x, y, width, height);
+        GLState::blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+        compositeShader.use();
+        compositeShader.setIvec2("viewportOrigin", x, y);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, textures[0].ID);
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, textures[1].ID);
+        emptyVertexArray.bind();
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+
+        glActiveTexture(GL_TEXTURE0);
+        GLState::disable(GL_BLEND);
+    }
+
+    // bytes of GPU memory used besides the programs
+    size_t memoryUsage() const
+    {
+        return (size_t)width * height * (8 + 2);
+    }
+
+private:
+    Program pointShader;
+    Program compositeShader;
+    Framebuffer framebuffer;
+    Texture textures[2];
+    VertexArray emptyVertexArray;
+    int width, height;
+
+    // new objects at every size, as texture storage cannot be resized
+    void allocate(int newWidth, int newHeight)
+    {
+        width = newWidth;
+        height = newHeight;
+
+        framebuffer = Framebuffer();
+        const GLenum formats[] = {GL_RGBA16F, GL_R16F};
+        const GLenum channels[] = {GL_RGBA, GL_RED};
+        for (int i = 0; i < 2; i++)
+        {
+            textures[i] = Texture();
+            textures[i].storage(formats[i], width, height, channels[i], GL_HALF_FLOAT);
+            framebuffer.attach(GL_COLOR_ATTACHMENT0 + i, textures[i]);
+        }
+        const GLenum drawBuffers[] = {GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1};
+        framebuffer.drawBuffers(2, drawBuffers);
+        if (!framebuffer.complete())
+            std::cout << "ERROR::OIT::FRAMEBUFFER_INCOMPLETE" << std::endl;
+    }
+};
+
+/**
+ * Exact order-independent transparency with per-pixel linked lists (GL 4.3).
+ *
+ * The build pass appends every fragment to a list per pixel, stored in a node pool
+ * of fixed capacity; fragments past the capacity are dropped rather than growing
+ * memory. The resolve pass sorts up to MAX_FRAGMENTS per pixel, blends them back to
+ * front over the framebuffer and resets the list heads for the next frame.
+ */
+class LinkedListOIT
+{
+public:
+    static constexpr unsigned int END_OF_LIST = 0xFFFFFFFFu;
+    static constexpr int NODE_SIZE = 16;
+
+    // nodesPerPixel sets the pool capacity relative to the viewport area
+    LinkedListOIT(const fs::path& shaderDir, const std::vector<ShaderConstant>& constants, float nodesPerPixel = 2.0f)
+        : pointShader(Shader((shaderDir / "vertex.glsl").string(), (shaderDir / "oit_list_fragment.glsl").string(), constants)),
+          resolveShader(Shader((shaderDir / "fullscreen_vertex.glsl").string(), (shaderDir / "oit_list_resolve_fragment.glsl").string())),
+          nodesPerPixel(nodesPerPixel), capacity(0), width(0), height(0)
+    {
+    }
+
+    static bool supported()
+    {
+        return GLAD_GL_VERSION_4_3;
+    }
+
+    Shader& shader()
+    {
+        return pointShader;
+    }
+
+    // Resets the node counter and binds the lists; reallocates on resize. The lists
+    // only cover the viewport, so fragments are stored relative to its origin
+    void begin(int viewportWidth, int viewportHeight, int x = 0, int y = 0)
+    {
+        if (viewportWidth != width || viewportHeight != height)
+            allocate(viewportWidth, viewportHeight);
+
+        const unsigned int zero = 0;
+        nodeCounter.subData(0, sizeof(zero), &zero);
+        GLState::bindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, nodeCounter.ID);
+        GLState::bindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, nodePool.ID);
+        glBindImageTexture(0, headTexture.ID, 0, GL_FALSE, 0, GL_READ_WRITE, GL_R32UI);
+
+        // fragments only go to the lists
+        GLState::disable(GL_DEPTH_TEST);
+        GLState::disable(GL_BLEND);
+        GLState::colorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+        pointShader.use();
+        pointShader.setUint("nodeCapacity", capacity);
+        pointShader.setIvec2("viewportOrigin", x, y);
+    }
+
+    // Resolves the lists over the given framebuffer and viewport
+    void end(unsigned int target, int x, int y)
+    {
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+        GLState::colorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+        glBindFramebuffer(GL_FRAMEBUFFER, target);
+        glViewport(x, y, width, height);
+        GLState::enable(GL_BLEND);
+        GLState::blendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+
+        resolveShader.use();
+        resolveShader.setIvec2("viewportOrigin", x, y);
+        emptyVertexArray.bind();
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+
+        GLState::disable(GL_BLEND);
+        // the resolve pass emptied the heads; the next build must see that
+        glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+    }
+
+    size_t memoryUsage() const
+    {
+        return (size_t)width * height * 4 + (size_t)capacity * NODE_SIZE + sizeof(unsigned int);
+    }
+
+private:
+    Program pointShader;
+    Program resolveShader;
+    float nodesPerPixel;
+    Texture headTexture;
+    Buffer nodeCounter, nodePool;
+    VertexArray emptyVertexArray;
+    unsigned int capacity;
+    int width, height;
+
+    void allocate(int newWidth, int newHeight)
+    {
+        width = newWidth;
+        height = newHeight;
+        capacity = (unsigned int)(nodesPerPixel * width * height);
+
+        // every head starts empty; afterwards the resolve pass keeps them empty
+        std::vector<unsigned int> emptyHeads((size_t)width * height, END_OF_LIST);
+        headTexture = Texture();
+        headTexture.storage(GL_R32UI, width, height, GL_RED_INTEGER, GL_UNSIGNED_INT, emptyHeads.data());
+
+        nodeCounter.data(sizeof(unsigned int), NULL, GL_DYNAMIC_DRAW);
+        nodePool.data((GLsizeiptr)capacity * NODE_SIZE, NULL, GL_DYNAMIC_DRAW);
+    }
+};
+
+#endif  // OIT_H
@@ -0,0 +1,72 @@
+#ifndef POINT_MODES_H
+#define POINT_MODES_H
+
+#include <glad.h>
+
+#include <gl_state.h>
+
+// How fragment.glsl turns square point sprites into round points. The value is
+// baked into the shader as the POINT_MODE constant, so each mode compiles to a
+// program containing only its own path; only the discard modes contain a discard
+// and lose early depth testing.
+enum PointMode
+{
+    POINT_MODE_DISCARD = 0,             // length(coord) > 0.5 is discarded (original)
+    POINT_MODE_SQUARED_DISTANCE = 1,    // dot(coord, coord) > 0.25 is discarded, no sqrt
+    POINT_MODE_ALPHA_TO_COVERAGE = 2,   // edge coverage in alpha, resolved by MSAA
+    POINT_MODE_SQUARE = 3,              // no fragment test; fine for points a few pixels wide
+    POINT_MODE_ANALYTIC = 4,            // fwidth edge coverage, blended at 1x sample rate
+};
+
+const int POINT_MODE_COUNT = 5;
+
+// Pixels an analytic point's sprite is wider than its circle, so the antialiased edge
+// is never cut off; mirrors src/shaders/point_sprite.glsl
+const float ANALYTIC_SPRITE_MARGIN = 2.0f;
+
+inline const char* pointModeName(PointMode mode) {
+    switch (mode) {
+        case POINT_MODE_DISCARD:            return "discard";
+        case POINT_MODE_SQUARED_DISTANCE:   return "squared-distance";
+        case POINT_MODE_ALPHA_TO_COVERAGE:  return "alpha-to-coverage";
+        case POINT_MODE_SQUARE:             return "square";
+        case POINT_MODE_ANALYTIC:           return "analytic";
+    }
+    return "unknown";
+} /* pointModeName() */
+
+// Blended modes look right only when drawn back to front, see depth_sort.h
+inline bool pointModeBlends(PointMode mode) {
+    return mode == POINT_MODE_ANALYTIC;
+} /* pointModeBlends() */
+
+// Alpha-to-coverage only smooths edges on a multisampled framebuffer
+inline bool pointModeNeedsMultisample(PointMode mode) {
+    return mode == POINT_MODE_ALPHA_TO_COVERAGE;
+} /* pointModeNeedsMultisample() */
+
+/**
+ * Sets the fixed-function state a mode relies on. Call before drawing with the
+ * program built for that mode.
+ */
+inline void applyPointMode(PointMode mode) {
+    if (mode == POINT_MODE_ALPHA_TO_COVERAGE) {
+        GLState::enable(GL_MULTISAMPLE);
+        GLState::enable(GL_SAMPLE_ALPHA_TO_COVERAGE);
+    } else {
+        GLState::disable(GL_SAMPLE_ALPHA_TO_COVERAGE);
+    }
+
+    // The analytic mode writes premultiplied color; blended points must not
+    // hide each other in the depth buffer
+    if (pointModeBlends(mode)) {
+        GLState::enable(GL_BLEND);
+        GLState::blendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+        GLState::depthMask(GL_FALSE);
+    } else {
+        GLState::disable(GL_BLEND);
+        GLState::depthMask(GL_TRUE);
+    }
+} /* applyPointMode() */
+
+#endif  // POINT_MODES_H
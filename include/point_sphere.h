@@ -0,0 +1,126 @@
+#ifndef POINT_SPHERE_H
+#define POINT_SPHERE_H
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <generator.h>
+#include <oit.h>
+#include <point_modes.h>
+#include <shader.h>
+#include <stream_buffer.h>
+
+/**
+ * What the sphere looks like and how it is drawn. The defaults are the
+ * point-sphere program's.
+ */
+struct PointSphereConfig
+{
+    int numPoints = 2000;
+    float scale = 0.9f;                     // radius of the sphere
+    PointGenerator generator = POINT_GENERATOR_SPIRAL;
+    unsigned int seed = 1;                  // of POINT_GENERATOR_RANDOM
+    float rotationSpeed = 0.07f;            // radians per second
+    float pointSizeOffset = 0.5f;           // point size in pixels is (z + offset) / divisor, for rotated z in [-1, 1]
+    float pointSizeDivisor = 0.23f;
+    float depthThreshold = 0.3f;            // points farther than this (smaller depth) are drawn black
+    float pointScale = 1.0f;                // factor on every point size, for tiled renders
+    bool opaqueLook = false;                // hide the far hemisphere, as if the sphere were opaque
+    PointMode pointMode = POINT_MODE_DISCARD;
+    int depthSort = 0;                      // 1 draws back to front sorted on the CPU, 2 on the GPU where available
+    TransparencyMode transparencyMode = TRANSPARENCY_NONE;
+    float transparentAlpha = 0.5f;
+    bool animated = false;                  // ripple the sphere, streaming the positions every frame
+    float animationAmplitude = 0.05f;
+    int numSpheres = 1;                     // above 1, a grid of spheres drawn with one instanced call
+    float sphereSpin = 0.0f;                // radians per second each grid sphere turns about its own axis
+    BufferStrategy bufferStrategy = BUFFER_PERSISTENT;     // of the per-frame constants and animated points
+    bool stateStats = false;                // print the GL state changes per frame every 60 frames
+    fs::path shaderDir;                     // the GLSL sources, src/shaders
+    fs::path spirvDir;                      // precompiled SPIR-V modules; GLSL is used when they are missing
+
+    // The constants specialized into the shaders (SPIR-V constant_id / GLSL #define)
+    std::vector<ShaderConstant> shaderConstants() const;
+
+    // The fastest a point can move on screen, in pixels per second of time, for a
+    // viewport of the given size; see FramePacer
+    float pixelsPerSecond(int viewportSize) const;
+};
+
+// What a frame depends on besides the configuration
+struct FrameInput
+{
+    float time = 0.0f;                                  // seconds; drives the rotation and the animation
+    glm::vec3 axis = glm::vec3(-2.0f, 3.0f, 1.0f);      // rotation axis, any length
+    glm::quat orientation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);  // turned after the rotation, e.g. by a drag
+    int framebufferWidth = 1, framebufferHeight = 1;    // points fill its largest centered square
+    unsigned int framebuffer = 0;
+    glm::mat4 projection = glm::mat4(1.0f);             // e.g. one tile of a poster
+    bool clear = true;
+};
+
+// Callbacks of PointSphere::run()
+struct FrameHooks
+{
+    // Before each frame: updates its input, which keeps the previous frame's values; false ends the loop
+    std::function<bool(int frame, FrameInput& input)> beginFrame;
+    // After each frame is drawn, e.g. to read it back or swap buffers; false ends the loop
+    std::function<bool(int frame)> endFrame;
+};
+
+/**
+ * The point-sphere renderer. It generates the points, builds the programs and
+ * buffers the configuration needs and draws frames into the current GL context;
+ * the context, the window and what happens to the frames stay with the caller.
+ *
+ * Create it with the context current and GL loaded (gladLoadGLLoader), and
+ * destroy it while the context is still current. Each render() sets the state
+ * it draws with, so several renderers can share a context, e.g. one per view.
+ * State is set through the GLState tracker, which skips calls that match what it
+ * last set; a caller whose own GL code changes state between frames calls
+ * invalidateState() before the next render().
+ */
+class PointSphere
+{
+public:
+    explicit PointSphere(const PointSphereConfig& config);
+    ~PointSphere();
+
+    PointSphere(const PointSphere&) = delete;
+    PointSphere& operator=(const PointSphere&) = delete;
+
+    const PointSphereConfig& config() const;
+
+    // The generated points, in the order they are drawn
+    const std::vector<vec3local>& points() const;
+
+    // PointSphereConfig::pixelsPerSecond() of the configuration
+    float pixelsPerSecond(int viewportSize) const;
+
+    /**
+     * Takes a new configuration that differs only in what applies from the next frame
+     * on: rotationSpeed, animationAmplitude and stateStats. Anything else needs new
+     * points, programs or buffers: nothing changes and false is returned, so the caller
+     * builds a new PointSphere instead.
+     */
+    bool reconfigure(const PointSphereConfig& config);
+
+    // Draws one frame into input.framebuffer
+    void render(const FrameInput& input);
+
+    // Forgets the GL state GLState tracked, after GL calls made outside it
+    void invalidateState();
+
+    // Renders frames until a hook returns false; returns the number of frames drawn
+    int run(const FrameHooks& hooks);
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl;
+};
+
+#endif  // POINT_SPHERE_H
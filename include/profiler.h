@@ -0,0 +1,334 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <glad.h>
+
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <trace.h>
+
+/**
+ * Frame-time profiler: nested CPU scopes and GPU scopes, aggregated per frame.
+ *
+ * Every scope is identified by its name and its parent, so the same name under two
+ * parents is two entries. Each frame adds one sample per scope (the sum of its calls
+ * that frame) and report() prints the p50/p95/p99 of the last MAX_FRAMES frames.
+ *
+ * GPU scopes also time the GPU with GL_TIME_ELAPSED queries. Queries are read
+ * RING_FRAMES frames later, when they are normally done, so reading them never
+ * stalls; a frame whose results are still not ready then is dropped and counted.
+ * GL cannot nest elapsed-time queries, so a GPU scope inside another only gets
+ * its CPU time.
+ *
+ * Use the PROFILE_* macros: the profiler part compiles to nothing unless
+ * POINT_SPHERE_PROFILE is defined (cmake -DPOINT_SPHERE_PROFILE=ON). The frames and
+ * scopes are also trace events (trace.h), which cost a branch while no trace runs.
+ */
+class Profiler
+{
+public:
+    static const int RING_FRAMES = 4;
+    static const int MAX_FRAMES = 10000;
+
+    static void beginFrame()
+    {
+        collectGpu(frame % RING_FRAMES);
+        frameStart = now();
+        current = -1;
+    }
+
+    static void endFrame()
+    {
+        for (Scope& scope : scopes)
+        {
+            if (scope.calls > 0)
+                addSample(scope.cpuSamples, scope.cpuThisFrame);
+            scope.calls = 0;
+            scope.cpuThisFrame = 0.0;
+        }
+        addSample(frameSamples, now() - frameStart);
+        frame++;
+
+        if (reportRequested)
+        {
+            reportRequested = 0;
+            report(stderr);
+        }
+    }
+
+    static void beginScope(const char* name, bool gpu)
+    {
+        auto key = std::make_pair(current, std::string(name));
+        auto found = scopeIndex.find(key);
+        int index;
+        if (found != scopeIndex.end())
+        {
+            index = found->second;
+        }
+        else
+        {
+            index = (int)scopes.size();
+            scopes.push_back(Scope());
+            scopes[index].name = name;
+            scopes[index].parent = current;
+            scopes[index].depth = current < 0 ? 0 : scopes[current].depth + 1;
+            scopeIndex[key] = index;
+        }
+
+        Scope& scope = scopes[index];
+        scope.calls++;
+        scope.totalCalls++;
+        scope.start = now();
+        scope.gpu = gpu && gpuScope < 0;
+        if (scope.gpu)
+        {
+            glBeginQuery(GL_TIME_ELAPSED, nextQuery(index));
+            gpuScope = index;
+        }
+        current = index;
+    }
+
+    static void endScope()
+    {
+        Scope& scope = scopes[current];
+        if (scope.gpu)
+        {
+            glEndQuery(GL_TIME_ELAPSED);
+            gpuScope = -1;
+        }
+        scope.cpuThisFrame += now() - scope.start;
+        current = scope.parent;
+    }
+
+    // Makes the next endFrame() print the report to stderr; safe in a signal handler
+    static void requestReport(int = 0)
+    {
+        reportRequested = 1;
+    }
+
+    // Prints the report whenever the process receives the signal, e.g. kill -USR1 <pid>
+    static void reportOnSignal(int signal)
+    {
+        std::signal(signal, requestReport);
+    }
+
+    static void report(FILE* out)
+    {
+        fprintf(out, "%-32s %8s %27s %27s\n", "scope (ms)", "calls", "CPU p50 / p95 / p99", "GPU p50 / p95 / p99");
+        printRow(out, "frame", 1.0, frameSamples, std::vector<double>());
+        for (int index : treeOrder())
+        {
+            const Scope& scope = scopes[index];
+            std::string name = std::string(2 * (scope.depth + 1), ' ') + scope.name;
+            double calls = frame == 0 ? 0.0 : (double)scope.totalCalls / frame;
+            printRow(out, name, calls, scope.cpuSamples, scope.gpuSamples);
+        }
+        fprintf(out, "%d frames, %d with GPU times dropped\n", frame, droppedFrames);
+    }
+
+    // Deletes the queries; call while the context is current
+    static void terminate()
+    {
+        for (std::vector<Query>& queries : ring)
+        {
+            for (Query& query : queries)
+                glDeleteQueries(1, &query.id);
+            queries.clear();
+        }
+        for (std::vector<unsigned int>& pool : freeQueries)
+        {
+            if (!pool.empty())
+                glDeleteQueries((GLsizei)pool.size(), pool.data());
+            pool.clear();
+        }
+    }
+
+private:
+    struct Scope
+    {
+        std::string name;
+        int parent, depth;
+        bool gpu = false;               // timing the GPU this call
+        int calls = 0;                  // this frame
+        long totalCalls = 0;
+        double start = 0.0;
+        double cpuThisFrame = 0.0;
+        std::vector<double> cpuSamples, gpuSamples;     // milliseconds, oldest overwritten first
+    };
+
+    struct Query
+    {
+        unsigned int id;
+        int scope;
+    };
+
+    static inline std::vector<Scope> scopes;
+    static inline std::map<std::pair<int, std::string>, int> scopeIndex;     // (parent, name) -> scope
+    static inline int current = -1, gpuScope = -1;
+    static inline int frame = 0, droppedFrames = 0;
+    static inline double frameStart = 0.0;
+    static inline std::vector<double> frameSamples;
+    static inline std::vector<Query> ring[RING_FRAMES];     // queries issued in each frame of the ring
+    static inline std::vector<unsigned int> freeQueries[RING_FRAMES];
+    static inline volatile std::sig_atomic_t reportRequested = 0;
+
+    static double now()
+    {
+        using clock = std::chrono::steady_clock;
+        return std::chrono::duration<double, std::milli>(clock::now().time_since_epoch()).count();
+    }
+
+    static void addSample(std::vector<double>& samples, double value)
+    {
+        if (samples.size() < MAX_FRAMES)
+            samples.push_back(value);
+        else
+            samples[frame % MAX_FRAMES] = value;
+    }
+
+    static unsigned int nextQuery(int scope)
+    {
+        std::vector<unsigned int>& pool = freeQueries[frame % RING_FRAMES];
+        unsigned int id;
+        if (pool.empty())
+        {
+            glGenQueries(1, &id);
+        }
+        else
+        {
+            id = pool.back();
+            pool.pop_back();
+        }
+        ring[frame % RING_FRAMES].push_back({id, scope});
+        return id;
+    }
+
+    // Reads the GPU times of the frame issued RING_FRAMES frames ago, without waiting
+    static void collectGpu(int slot)
+    {
+        std::vector<Query>& queries = ring[slot];
+        if (queries.empty())
+            return;
+
+        // queries finish in order, so the last one being ready means they all are
+        GLint available = 0;
+        glGetQueryObjectiv(queries.back().id, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available)
+        {
+            std::map<int, double> times;
+            for (const Query& query : queries)
+            {
+                GLuint64 elapsed = 0;
+                glGetQueryObjectui64v(query.id, GL_QUERY_RESULT, &elapsed);
+                times[query.scope] += elapsed * 1e-6;
+            }
+            for (const auto& [scope, time] : times)
+                addSample(scopes[scope].gpuSamples, time);
+        }
+        else
+        {
+            // still busy; reusing the queries now would mean waiting for them
+            droppedFrames++;
+            for (const Query& query : queries)
+                glDeleteQueries(1, &query.id);
+            queries.clear();
+            return;
+        }
+        for (const Query& query : queries)
+            freeQueries[slot].push_back(query.id);
+        queries.clear();
+    }
+
+    // Parents before children, siblings in the order they were first seen
+    static std::vector<int> treeOrder()
+    {
+        std::vector<int> order, stack;
+        for (int index = (int)scopes.size() - 1; index >= 0; index--)
+        {
+            if (scopes[index].parent < 0)
+                stack.push_back(index);
+        }
+        while (!stack.empty())
+        {
+            int index = stack.back();
+            stack.pop_back();
+            order.push_back(index);
+            for (int child = (int)scopes.size() - 1; child >= 0; child--)
+            {
+                if (scopes[child].parent == index)
+                    stack.push_back(child);
+            }
+        }
+        return order;
+    }
+
+    static double percentile(std::vector<double> samples, double fraction)
+    {
+        if (samples.empty())
+            return 0.0;
+        size_t rank = std::min(samples.size() - 1, (size_t)(fraction * samples.size()));
+        std::nth_element(samples.begin(), samples.begin() + rank, samples.end());
+        return samples[rank];
+    }
+
+    static void printRow(FILE* out, const std::string& name, double calls,
+                         const std::vector<double>& cpu, const std::vector<double>& gpu)
+    {
+        char cpuColumn[64] = "-", gpuColumn[64] = "-";
+        if (!cpu.empty())
+            snprintf(cpuColumn, sizeof(cpuColumn), "%7.3f /%7.3f /%7.3f",
+                     percentile(cpu, 0.5), percentile(cpu, 0.95), percentile(cpu, 0.99));
+        if (!gpu.empty())
+            snprintf(gpuColumn, sizeof(gpuColumn), "%7.3f /%7.3f /%7.3f",
+                     percentile(gpu, 0.5), percentile(gpu, 0.95), percentile(gpu, 0.99));
+        fprintf(out, "%-32s %8.2f %27s %27s\n", name.c_str(), calls, cpuColumn, gpuColumn);
+    }
+};
+
+// Times the enclosing block on the CPU, or on the CPU and GPU
+class ProfileScope
+{
+public:
+    explicit ProfileScope(const char* name, bool gpu = false)
+    {
+        Profiler::beginScope(name, gpu);
+    }
+
+    ~ProfileScope()
+    {
+        Profiler::endScope();
+    }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+#ifdef POINT_SPHERE_PROFILE
+#define PROFILE_FRAME_BEGIN() (Trace::beginFrame(), Profiler::beginFrame())
+#define PROFILE_FRAME_END() (Profiler::endFrame(), Trace::endFrame())
+#define PROFILE_SCOPE(name) TRACE_SCOPE(name); ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define PROFILE_GPU_SCOPE(name) TRACE_GPU_SCOPE(name); ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name, true)
+#define PROFILE_REPORT_ON_SIGNAL(signal) Profiler::reportOnSignal(signal)
+#define PROFILE_REPORT() Profiler::report(stderr)
+#define PROFILE_TERMINATE() Profiler::terminate()
+#else
+#define PROFILE_FRAME_BEGIN() Trace::beginFrame()
+#define PROFILE_FRAME_END() Trace::endFrame()
+#define PROFILE_SCOPE(name) TRACE_SCOPE(name)
+#define PROFILE_GPU_SCOPE(name) TRACE_GPU_SCOPE(name)
+#define PROFILE_REPORT_ON_SIGNAL(signal) ((void)0)
+#define PROFILE_REPORT() ((void)0)
+#define PROFILE_TERMINATE() ((void)0)
+#endif
+
+#endif  // PROFILER_H
@@ -0,0 +1,219 @@
+#ifndef ROTATION_STATE_H
+#define ROTATION_STATE_H
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+// The AVX2 kernel is compiled per function and picked at run time, like the
+// CPU rasterizer's, so the build needs no -mavx2
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define ROTATION_BATCH_AVX2 1
+#include <immintrin.h>
+#else
+#define ROTATION_BATCH_AVX2 0
+#endif
+
+/**
+ * An orientation that turns at an angular velocity, advanced by the time since the
+ * last frame instead of rebuilt from the total time. Changing the velocity turns on
+ * from where the orientation is, so a new axis never makes it jump. The matrix is
+ * only rebuilt when the orientation has changed since it was last asked for.
+ */
+class RotationState
+{
+public:
+    glm::vec3 angularVelocity = glm::vec3(0.0f);     // world axis times radians per second
+
+    RotationState() = default;
+
+    RotationState(const glm::quat& orientation, const glm::vec3& angularVelocity)
+        : angularVelocity(angularVelocity), current(orientation)
+    {
+    }
+
+    // Turns by the angular velocity over the given seconds; exact for steps of any length
+    void integrate(float seconds)
+    {
+        float speed = glm::length(angularVelocity);
+        float angle = speed * seconds;
+        if (angle == 0.0f)
+            return;
+        current = glm::normalize(glm::angleAxis(angle, angularVelocity / speed) * current);
+        stale = true;
+    }
+
+    const glm::quat& orientation() const
+    {
+        return current;
+    }
+
+    void setOrientation(const glm::quat& orientation)
+    {
+        current = orientation;
+        stale = true;
+    }
+
+    const glm::mat3& matrix()
+    {
+        if (stale)
+        {
+            rotation = glm::mat3_cast(current);
+            stale = false;
+        }
+        return rotation;
+    }
+
+private:
+    glm::quat current = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+    glm::mat3 rotation = glm::mat3(1.0f);
+    bool stale = false;
+};
+
+/**
+ * Many RotationStates advanced together, e.g. the spheres of an instanced grid.
+ * The quaternions and velocities are stored as separate arrays of x, y, z and w so
+ * integrate() updates eight of them per AVX2 instruction.
+ *
+ * Each step is the update q += h (0, omega) q followed by a renormalization, which
+ * needs no trigonometry: it turns by 2 atan(h |omega|). With h = dt / 2 scaled by
+ * 1 + (|omega| dt / 2)^2 / 3, the start of tan's series, that is |omega| dt to fifth
+ * order; steps longer than MAX_STEP are split to keep it so. The scalar and AVX2
+ * paths give the same results.
+ */
+class RotationBatch
+{
+public:
+    static constexpr float MAX_STEP = 1.0f / 60.0f;     // seconds
+
+    void add(const glm::quat& orientation, const glm::vec3& angularVelocity)
+    {
+        qx.push_back(orientation.x);
+        qy.push_back(orientation.y);
+        qz.push_back(orientation.z);
+        qw.push_back(orientation.w);
+        vx.push_back(angularVelocity.x);
+        vy.push_back(angularVelocity.y);
+        vz.push_back(angularVelocity.z);
+    }
+
+    size_t size() const
+    {
+        return qw.size();
+    }
+
+    glm::quat orientation(size_t index) const
+    {
+        return glm::quat(qw[index], qx[index], qy[index], qz[index]);
+    }
+
+    glm::vec3 angularVelocity(size_t index) const
+    {
+        return glm::vec3(vx[index], vy[index], vz[index]);
+    }
+
+    glm::mat3 matrix(size_t index) const
+    {
+        return glm::mat3_cast(orientation(index));
+    }
+
+    static bool simd()
+    {
+        #if ROTATION_BATCH_AVX2
+        return __builtin_cpu_supports("avx2");
+        #else
+        return false;
+        #endif
+    }
+
+    // Advances every orientation by the given seconds, with AVX2 when the CPU has it
+    void integrate(float seconds, bool vectorized = simd())
+    {
+        int steps = std::max(1, (int)std::ceil(std::fabs(seconds) / MAX_STEP));
+        float half = seconds / steps * 0.5f;
+        for (int step = 0; step < steps; step++)
+        {
+            size_t first = 0;
+            #if ROTATION_BATCH_AVX2
+            if (vectorized)
+                first = integrateAVX2(half);
+            #else
+            (void)vectorized;
+            #endif
+            integrateScalar(half, first);
+        }
+    }
+
+private:
+    std::vector<float> qx, qy, qz, qw;
+    std::vector<float> vx, vy, vz;
+
+    // One step from index first on; the same operations in the same order as the AVX2 path
+    void integrateScalar(float half, size_t first)
+    {
+        for (size_t i = first; i < size(); i++)
+        {
+            float x = qx[i], y = qy[i], z = qz[i], w = qw[i];
+            float hx = vx[i] * half, hy = vy[i] * half, hz = vz[i] * half;
+            float correction = 1.0f + (hx * hx + hy * hy + hz * hz) * (1.0f / 3.0f);
+            hx = hx * correction;
+            hy = hy * correction;
+            hz = hz * correction;
+            float nw = w - (hx * x + hy * y + hz * z);
+            float nx = x + (hx * w + (hy * z - hz * y));
+            float ny = y + (hy * w + (hz * x - hx * z));
+            float nz = z + (hz * w + (hx * y - hy * x));
+            float scale = 1.0f / std::sqrt(nx * nx + ny * ny + (nz * nz + nw * nw));
+            qx[i] = nx * scale;
+            qy[i] = ny * scale;
+            qz[i] = nz * scale;
+            qw[i] = nw * scale;
+        }
+    }
+
+    #if ROTATION_BATCH_AVX2
+    // One step for the largest multiple of eight; returns where the scalar path goes on
+    __attribute__((target("avx2")))
+    size_t integrateAVX2(float halfStep)
+    {
+        const size_t count = size() / 8 * 8;
+        const __m256 half = _mm256_set1_ps(halfStep);
+        const __m256 one = _mm256_set1_ps(1.0f);
+        const __m256 third = _mm256_set1_ps(1.0f / 3.0f);
+        for (size_t i = 0; i < count; i += 8)
+        {
+            __m256 x = _mm256_loadu_ps(&qx[i]), y = _mm256_loadu_ps(&qy[i]);
+            __m256 z = _mm256_loadu_ps(&qz[i]), w = _mm256_loadu_ps(&qw[i]);
+            __m256 hx = _mm256_mul_ps(_mm256_loadu_ps(&vx[i]), half);
+            __m256 hy = _mm256_mul_ps(_mm256_loadu_ps(&vy[i]), half);
+            __m256 hz = _mm256_mul_ps(_mm256_loadu_ps(&vz[i]), half);
+            __m256 correction = _mm256_add_ps(one, _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(hx, hx), _mm256_mul_ps(hy, hy)),
+                                                                               _mm256_mul_ps(hz, hz)), third));
+            hx = _mm256_mul_ps(hx, correction);
+            hy = _mm256_mul_ps(hy, correction);
+            hz = _mm256_mul_ps(hz, correction);
+
+            __m256 dot = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(hx, x), _mm256_mul_ps(hy, y)), _mm256_mul_ps(hz, z));
+            __m256 nw = _mm256_sub_ps(w, dot);
+            __m256 nx = _mm256_add_ps(x, _mm256_add_ps(_mm256_mul_ps(hx, w), _mm256_sub_ps(_mm256_mul_ps(hy, z), _mm256_mul_ps(hz, y))));
+            __m256 ny = _mm256_add_ps(y, _mm256_add_ps(_mm256_mul_ps(hy, w), _mm256_sub_ps(_mm256_mul_ps(hz, x), _mm256_mul_ps(hx, z))));
+            __m256 nz = _mm256_add_ps(z, _mm256_add_ps(_mm256_mul_ps(hz, w), _mm256_sub_ps(_mm256_mul_ps(hx, y), _mm256_mul_ps(hy, x))));
+
+            __m256 lengthSquared = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(nx, nx), _mm256_mul_ps(ny, ny)),
+                                                 _mm256_add_ps(_mm256_mul_ps(nz, nz), _mm256_mul_ps(nw, nw)));
+            __m256 scale = _mm256_div_ps(one, _mm256_sqrt_ps(lengthSquared));
+            _mm256_storeu_ps(&qx[i], _mm256_mul_ps(nx, scale));
+            _mm256_storeu_ps(&qy[i], _mm256_mul_ps(ny, scale));
+            _mm256_storeu_ps(&qz[i], _mm256_mul_ps(nz, scale));
+            _mm256_storeu_ps(&qw[i], _mm256_mul_ps(nw, scale));
+        }
+        return count;
+    }
+    #endif
+};
+
+#endif  // ROTATION_STATE_H
@@ -0,0 +1,318 @@
+#ifndef SETTINGS_H
+#define SETTINGS_H
+
+#include <climits>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <point_sphere.h>
+#include <trace.h>
+
+// What it takes for a changed setting to apply
+enum SettingReload
+{
+    RELOAD_FRAME = 0,       // the next frame
+    RELOAD_SPHERE = 1,      // a new PointSphere: points, programs and buffers, in the same context
+    RELOAD_RESTART = 2,     // a new window or context, so only read at startup
+};
+
+/**
+ * The point-sphere program's parameters, set at run time from a settings file
+ * (--config) and the command line (--name value) rather than compiled in. The
+ * defaults are the program's.
+ */
+struct Settings
+{
+    PointSphereConfig sphere;
+    int width = 440;
+    int height = 405;
+    bool mouseTracking = false;     // turn the sphere by dragging it with the left mouse button
+    double targetFps = 60.0;        // the window draws at most this often, 0 for no limit
+    double pacingPixels = 1.0;      // and once the sphere can have moved this far, 0 for every frame
+    int posterTileSize = 4096;      // largest side of a poster tile; the context's limits may lower it
+    unsigned int traceEvents = Trace::DEFAULT_EVENTS;     // --trace keeps each thread's latest this many
+};
+
+// One named setting: how to read and write it and when a change takes effect
+struct SettingOption
+{
+    const char* name;
+    SettingReload reload;
+    const char* help;
+    std::function<bool(Settings&, const std::string&)> set;     // false for a value that does not parse
+    std::function<std::string(const Settings&)> get;
+    std::function<bool(const Settings&)> valid;                 // false for a value out of range
+};
+
+inline bool parseSetting(const std::string& text, int& value)
+{
+    char* end;
+    long parsed = std::strtol(text.c_str(), &end, 10);
+    if (text.empty() || *end != '\0' || parsed < INT_MIN || parsed > INT_MAX)
+        return false;
+    value = (int)parsed;
+    return true;
+}
+
+inline bool parseSetting(const std::string& text, unsigned int& value)
+{
+    char* end;
+    unsigned long parsed = std::strtoul(text.c_str(), &end, 10);
+    if (text.empty() || text[0] == '-' || *end != '\0' || parsed > UINT_MAX)
+        return false;
+    value = (unsigned int)parsed;
+    return true;
+}
+
+inline bool parseSetting(const std::string& text, double& value)
+{
+    char* end;
+    double parsed = std::strtod(text.c_str(), &end);
+    if (text.empty() || *end != '\0')
+        return false;
+    value = parsed;
+    return true;
+}
+
+inline bool parseSetting(const std::string& text, float& value)
+{
+    double parsed;
+    if (!parseSetting(text, parsed))
+        return false;
+    value = (float)parsed;
+    return true;
+}
+
+inline bool parseSetting(const std::string& text, bool& value)
+{
+    if (text == "1" || text == "true" || text == "on")
+        value = true;
+    else if (text == "0" || text == "false" || text == "off")
+        value = false;
+    else
+        return false;
+    return true;
+}
+
+// An enum value by its name, or by its number
+template <typename Enum>
+bool parseNamedSetting(const std::string& text, Enum& value, int count, const char* (*name)(Enum))
+{
+    for (int i = 0; i < count; i++)
+    {
+        if (text == name((Enum)i) || text == std::to_string(i))
+        {
+            value = (Enum)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+inline bool parseSetting(const std::string& text, PointMode& value)
+{
+    return parseNamedSetting(text, value, POINT_MODE_COUNT, pointModeName);
+}
+
+inline bool parseSetting(const std::string& text, TransparencyMode& value)
+{
+    return parseNamedSetting(text, value, 3, transparencyModeName);
+}
+
+inline bool parseSetting(const std::string& text, PointGenerator& value)
+{
+    return parseNamedSetting(text, value, 2, pointGeneratorName);
+}
+
+inline bool parseSetting(const std::string& text, BufferStrategy& value)
+{
+    return parseNamedSetting(text, value, 2, bufferStrategyName);
+}
+
+template <typename T>
+std::string formatSetting(const T& value)
+{
+    std::ostringstream out;
+    out << value;
+    return out.str();
+}
+
+inline std::string formatSetting(const bool& value)
+{
+    return value ? "true" : "false";
+}
+
+inline std::string formatSetting(const PointMode& value)
+{
+    return pointModeName(value);
+}
+
+inline std::string formatSetting(const TransparencyMode& value)
+{
+    return transparencyModeName(value);
+}
+
+inline std::string formatSetting(const PointGenerator& value)
+{
+    return pointGeneratorName(value);
+}
+
+inline std::string formatSetting(const BufferStrategy& value)
+{
+    return bufferStrategyName(value);
+}
+
+template <typename T>
+SettingOption settingOption(const char* name, SettingReload reload, const char* help, T& (*field)(Settings&), bool (*inRange)(double))
+{
+    return {name, reload, help,
+            [field](Settings& settings, const std::string& text) { return parseSetting(text, field(settings)); },
+            [field](const Settings& settings) { return formatSetting(field(const_cast<Settings&>(settings))); },
+            [field, inRange](const Settings& settings) { return inRange((double)field(const_cast<Settings&>(settings))); }};
+}
+
+// A setting whose value must satisfy the condition on value
+#define SETTING_WHERE(name, reload, member, condition, help) \
+    settingOption(name, reload, help, +[](Settings& settings) -> decltype((settings.member)) { return settings.member; }, \
+                  +[](double value) { (void)value; return (bool)(condition); })
+#define SETTING_AT_LEAST(name, reload, member, minimum, help) SETTING_WHERE(name, reload, member, value >= (minimum), help)
+#define SETTING_ABOVE(name, reload, member, bound, help) SETTING_WHERE(name, reload, member, value > (bound), help)
+#define SETTING_BETWEEN(name, reload, member, minimum, maximum, help) \
+    SETTING_WHERE(name, reload, member, value >= (minimum) && value <= (maximum), help)
+#define SETTING(name, reload, member, help) SETTING_WHERE(name, reload, member, true, help)
+
+// Every setting, in the order --settings prints them
+inline const std::vector<SettingOption>& settingOptions()
+{
+    static const std::vector<SettingOption> options = {
+        SETTING_AT_LEAST("num-points", RELOAD_SPHERE, sphere.numPoints, 2, "points on the sphere, at least 2"),
+        SETTING_ABOVE("scale", RELOAD_SPHERE, sphere.scale, 0, "radius of the sphere, above 0"),
+        SETTING("generator", RELOAD_SPHERE, sphere.generator, "spiral or random"),
+        SETTING("seed", RELOAD_SPHERE, sphere.seed, "of the random generator"),
+        SETTING("rotation-speed", RELOAD_FRAME, sphere.rotationSpeed, "radians per second"),
+        SETTING_AT_LEAST("width", RELOAD_RESTART, width, 1, "of the window or image"),
+        SETTING_AT_LEAST("height", RELOAD_RESTART, height, 1, "of the window or image"),
+        SETTING("mouse-tracking", RELOAD_FRAME, mouseTracking, "turn the sphere by dragging it with the left mouse button"),
+        SETTING_AT_LEAST("target-fps", RELOAD_FRAME, targetFps, 0, "most window frames per second, 0 for no limit"),
+        SETTING_AT_LEAST("pacing-pixels", RELOAD_FRAME, pacingPixels, 0, "how far the sphere moves between window frames, 0 for every frame"),
+        SETTING("point-size-offset", RELOAD_SPHERE, sphere.pointSizeOffset, "point size in pixels is (z + offset) / divisor"),
+        SETTING_ABOVE("point-size-divisor", RELOAD_SPHERE, sphere.pointSizeDivisor, 0, "for rotated z in [-1, 1], above 0"),
+        SETTING("depth-threshold", RELOAD_SPHERE, sphere.depthThreshold, "points farther than this depth (0 back, 1 front) are drawn black"),
+        SETTING("opaque-look", RELOAD_SPHERE, sphere.opaqueLook, "hide the far hemisphere"),
+        SETTING("point-mode", RELOAD_SPHERE, sphere.pointMode, "discard, squared-distance, alpha-to-coverage, square or analytic"),
+        SETTING_BETWEEN("depth-sort", RELOAD_SPHERE, sphere.depthSort, 0, 2, "1 draws back to front sorted on the CPU, 2 on the GPU"),
+        SETTING("transparency", RELOAD_SPHERE, sphere.transparencyMode, "none, weighted or linked-list"),
+        SETTING_BETWEEN("transparent-alpha", RELOAD_SPHERE, sphere.transparentAlpha, 0, 1, "opacity of translucent points, 0 to 1"),
+        SETTING("animated", RELOAD_SPHERE, sphere.animated, "ripple the sphere, streaming the positions every frame"),
+        SETTING("animation-amplitude", RELOAD_FRAME, sphere.animationAmplitude, "of the ripple"),
+        SETTING_AT_LEAST("num-spheres", RELOAD_SPHERE, sphere.numSpheres, 1, "above 1, a grid of spheres drawn with one instanced call"),
+        SETTING("sphere-spin", RELOAD_SPHERE, sphere.sphereSpin, "radians per second each grid sphere turns"),
+        SETTING("buffer-strategy", RELOAD_SPHERE, sphere.bufferStrategy, "persistent or subdata, for per-frame uploads"),
+        SETTING("state-stats", RELOAD_FRAME, sphere.stateStats, "print the GL state changes per frame"),
+        SETTING_AT_LEAST("poster-tile-size", RELOAD_RESTART, posterTileSize, 1, "largest side of a poster tile"),
+        SETTING_AT_LEAST("trace-events", RELOAD_RESTART, traceEvents, 1, "--trace keeps each thread's latest this many events"),
+    };
+    return options;
+}
+
+#undef SETTING
+#undef SETTING_AT_LEAST
+
+inline const SettingOption* findSetting(const std::string& name)
+{
+    for (const SettingOption& option : settingOptions())
+    {
+        if (name == option.name)
+            return &option;
+    }
+    return NULL;
+}
+
+// Sets one setting, reporting an unknown name or a bad value; a bad value leaves the settings as they were
+inline bool applySetting(Settings& settings, const std::string& name, const std::string& value)
+{
+    const SettingOption* option = findSetting(name);
+    if (option == NULL)
+    {
+        std::cerr << "ERROR::SETTINGS::UNKNOWN_SETTING " << name << std::endl;
+        return false;
+    }
+    Settings changed = settings;
+    if (!option->set(changed, value) || !option->valid(changed))
+    {
+        std::cerr << "ERROR::SETTINGS::INVALID_VALUE " << name << " = " << value << " (" << option->help << ")" << std::endl;
+        return false;
+    }
+    settings = changed;
+    return true;
+}
+
+inline std::string trimSetting(const std::string& text)
+{
+    size_t first = text.find_first_not_of(" \t\r");
+    if (first == std::string::npos)
+        return "";
+    return text.substr(first, text.find_last_not_of(" \t\r") - first + 1);
+}
+
+/**
+ * Reads the settings file, if any, then the command-line overrides over it.
+ * The file has one "name = value" per line; "#" starts a comment.
+ *
+ * @param settings Changed where the file and the overrides say
+ * @param path The settings file, or empty
+ * @param overrides (name, value) pairs, applied in order
+ * @return false if the file cannot be read or any line or override is invalid
+ */
+inline bool loadSettings(Settings& settings, const std::string& path,
+                         const std::vector<std::pair<std::string, std::string>>& overrides)
+{
+    bool valid = true;
+    if (!path.empty())
+    {
+        std::ifstream file(path);
+        if (!file)
+        {
+            std::cerr << "ERROR::SETTINGS::CANNOT_READ " << path << std::endl;
+            return false;
+        }
+        std::string line;
+        for (int number = 1; std::getline(file, line); number++)
+        {
+            line = trimSetting(line.substr(0, line.find('#')));
+            if (line.empty())
+                continue;
+            size_t equals = line.find('=');
+            if (equals == std::string::npos)
+            {
+                std::cerr << "ERROR::SETTINGS::SYNTAX " << path << ":" << number << ": " << line << std::endl;
+                valid = false;
+                continue;
+            }
+            valid = applySetting(settings, trimSetting(line.substr(0, equals)), trimSetting(line.substr(equals + 1))) && valid;
+        }
+    }
+    for (const auto& [name, value] : overrides)
+        valid = applySetting(settings, name, value) && valid;
+    return valid;
+}
+
+// The settings as a settings file, with what each means and when a change applies
+inline void printSettings(std::ostream& out, const Settings& settings)
+{
+    const char* reloads[] = {"next frame", "rebuilds the sphere", "restart"};
+    for (const SettingOption& option : settingOptions())
+    {
+        std::string line = std::string(option.name) + " = " + option.get(settings);
+        line.resize(std::max<size_t>(line.size() + 1, 32), ' ');
+        out << line << "# " << option.help << " [" << reloads[option.reload] << "]" << std::endl;
+    }
+}
+
+#endif  // SETTINGS_H
@@ -2,15 +2,37 @@
 #define SHADER_H
 
 #include <glad.h>
+#include <frame_constants.h>
+#include <gl_state.h>
 
 #include <string>
+#include <vector>
+#include <initializer_list>
+#include <unordered_map>
+#include <utility>
+#include <cstdint>
+#include <cstring>
 #include <fstream>
 #include <sstream>
+#include <iomanip>
 #include <iostream>
 
 #include <filesystem>
+
+#include <trace.h>
+
 namespace fs = std::filesystem;
 
+// A named constant baked into a shader when it is built. SPIR-V modules receive it
+// as the specialization constant with constant_id == id; GLSL sources receive it as
+// a "#define name value" line inserted after the #version directive.
+struct ShaderConstant
+{
+    unsigned int id;
+    std::string name;
+    float value;
+};
+
 class Shader
 {
 public:
@@ -18,7 +40,15 @@ public:
 
     // constructor generates the shader on the fly
     Shader(const std::string& vertexPath, const std::string& fragmentPath)
+        : Shader(vertexPath, fragmentPath, {})
+    {
+    }
+
+    // same as above, with the given constants defined in both stages
+    Shader(const std::string& vertexPath, const std::string& fragmentPath,
+           const std::vector<ShaderConstant>& constants)
     {
+        TRACE_SCOPE("build shader");
         // 1. retrieve the vertex/fragment source code from filePath
         std::string vertexCode;
         std::string fragmentCode;
@@ -56,8 +86,8 @@ public:
             vShaderFile.close();
             fShaderFile.close();
             // convert stream into string
-            vertexCode   = vShaderStream.str();
-            fragmentCode = fShaderStream.str();
+            vertexCode   = injectDefines(expandIncludes(vShaderStream.str(), fs::path(vertexPath).parent_path()), constants);
+            fragmentCode = injectDefines(expandIncludes(fShaderStream.str(), fs::path(fragmentPath).parent_path()), constants);
         }
         catch (std::ifstream::failure& e)
         {
@@ -78,52 +108,309 @@ public:
         glCompileShader(fragment);
         checkCompileErrors(fragment, "FRAGMENT");
         // shader Program
-        ID = glCreateProgram();
-        glAttachShader(ID, vertex);
-        glAttachShader(ID, fragment);
-        glLinkProgram(ID);
-        checkCompileErrors(ID, "PROGRAM");
-        // delete the shaders as they're linked into our program now and no longer necessary
-        glDeleteShader(vertex);
-        glDeleteShader(fragment);
+        ID = link({vertex, fragment});
+        spirv = false;
+    }
+
+    /**
+     * Builds the program from precompiled SPIR-V modules (GL 4.6 / GL_ARB_gl_spirv),
+     * specializing them with the given constants. If SPIR-V is not supported by the
+     * context, a module is missing or it fails to specialize, the GLSL sources are
+     * compiled instead with the same constants as #defines.
+     */
+    static Shader fromSpirv(const std::string& vertexSpvPath, const std::string& fragmentSpvPath,
+                            const std::string& vertexPath, const std::string& fragmentPath,
+                            const std::vector<ShaderConstant>& constants)
+    {
+        if (spirvSupported())
+        {
+            std::vector<uint32_t> vertexWords = readSpirv(vertexSpvPath);
+            std::vector<uint32_t> fragmentWords = readSpirv(fragmentSpvPath);
+            if (!vertexWords.empty() && !fragmentWords.empty())
+            {
+                unsigned int vertex = specialize(GL_VERTEX_SHADER, vertexWords, constants, "VERTEX");
+                unsigned int fragment = vertex != 0
+                    ? specialize(GL_FRAGMENT_SHADER, fragmentWords, constants, "FRAGMENT") : 0;
+                if (fragment != 0)
+                {
+                    Shader shader;
+                    shader.ID = link({vertex, fragment});
+                    shader.spirv = true;
+                    return shader;
+                }
+                if (vertex != 0)
+                    glDeleteShader(vertex);
+                std::cout << "ERROR::SHADER::SPIRV_SPECIALIZATION_FAILED: falling back to GLSL" << std::endl;
+            }
+        }
+        return Shader(vertexPath, fragmentPath, constants);
+    }
+
+    // Builds a compute program (GL 4.3) from a GLSL source file
+    static Shader compute(const std::string& computePath, const std::vector<ShaderConstant>& constants = {})
+    {
+        TRACE_SCOPE("build shader");
+        std::string computeCode;
+        std::ifstream cShaderFile;
+        cShaderFile.exceptions (std::ifstream::failbit | std::ifstream::badbit);
+        try
+        {
+            cShaderFile.open(computePath);
+            std::stringstream cShaderStream;
+            cShaderStream << cShaderFile.rdbuf();
+            cShaderFile.close();
+            computeCode = injectDefines(expandIncludes(cShaderStream.str(), fs::path(computePath).parent_path()), constants);
+        }
+        catch (std::ifstream::failure& e)
+        {
+            std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << e.what() << std::endl;
+        }
+        const char* cShaderCode = computeCode.c_str();
+        unsigned int compute = glCreateShader(GL_COMPUTE_SHADER);
+        glShaderSource(compute, 1, &cShaderCode, NULL);
+        glCompileShader(compute);
+        checkCompileErrors(compute, "COMPUTE");
+
+        Shader shader;
+        shader.ID = link({compute});
+        return shader;
     }
 
-    // activate the shader
+    // true when the context can consume SPIR-V modules
+    static bool spirvSupported()
+    {
+        return GLAD_GL_VERSION_4_6 || GLAD_GL_ARB_gl_spirv;
+    }
+
+    // true when the program was built from SPIR-V rather than GLSL
+    bool isSpirv() const
+    {
+        return spirv;
+    }
+
+    // activate the shader; a no-op when it is already active
     void use() 
     { 
-        glUseProgram(ID); 
+        GLState::useProgram(ID); 
     }
 
     // Setter functions
     void setBool(const std::string &name, bool value) const
-    {         
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value); 
+    {
+        glUniform1i(uniformLocation(name), (int)value);
     }
     void setInt(const std::string &name, int value) const
-    { 
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), value); 
+    {
+        glUniform1i(uniformLocation(name), value);
+    }
+    void setUint(const std::string &name, unsigned int value) const
+    {
+        glUniform1ui(uniformLocation(name), value);
+    }
+    void setIvec2(const std::string &name, int x, int y) const
+    {
+        glUniform2i(uniformLocation(name), x, y);
     }
     void setFloat(const std::string &name, float value) const
-    { 
-        glUniform1f(glGetUniformLocation(ID, name.c_str()), value); 
+    {
+        glUniform1f(uniformLocation(name), value);
     }
     void setVec4(const std::string &name, const float *value) const
     {
-        glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, value);
+        glUniform4fv(uniformLocation(name), 1, value);
     }
     void setMat4(const std::string &name, const float *value) const
     {
-        glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, value);
+        glUniformMatrix4fv(uniformLocation(name), 1, GL_FALSE, value);
     }
 
     void terminate()
     {
+        GLState::forgetProgram(ID);
         glDeleteProgram(ID);
+        ID = 0;
     }
 
 private:
+    bool spirv = false;
+    // uniform locations are looked up once per name instead of on every set call
+    mutable std::unordered_map<std::string, int> uniformLocations;
+
+    Shader() : ID(0) {}
+
+    int uniformLocation(const std::string &name) const
+    {
+        auto it = uniformLocations.find(name);
+        if (it != uniformLocations.end())
+            return it->second;
+        int location = glGetUniformLocation(ID, name.c_str());
+        uniformLocations.emplace(name, location);
+        return location;
+    }
+
+    // links the stages into a new program and deletes the stages
+    static unsigned int link(std::initializer_list<unsigned int> stages)
+    {
+        unsigned int program = glCreateProgram();
+        for (unsigned int stage : stages)
+            glAttachShader(program, stage);
+        glLinkProgram(program);
+        checkCompileErrors(program, "PROGRAM");
+        // every program reads the shared per-frame constants from the same binding
+        unsigned int block = glGetUniformBlockIndex(program, "FrameConstants");
+        if (block != GL_INVALID_INDEX)
+            glUniformBlockBinding(program, block, FRAME_CONSTANTS_BINDING);
+        // delete the shaders as they're linked into our program now and no longer necessary
+        for (unsigned int stage : stages)
+            glDeleteShader(stage);
+        return program;
+    }
+
+    // replaces every #include "file" line with the file's contents, relative to directory
+    static std::string expandIncludes(const std::string& source, const fs::path& directory, int depth = 0)
+    {
+        std::istringstream lines(source);
+        std::ostringstream result;
+        std::string line;
+        while (std::getline(lines, line))
+        {
+            size_t directive = line.find_first_not_of(" \t");
+            if (directive != std::string::npos && line.compare(directive, 8, "#include") == 0)
+            {
+                size_t open = line.find('"', directive);
+                size_t close = open == std::string::npos ? open : line.find('"', open + 1);
+                if (close == std::string::npos || depth > 8)
+                {
+                    std::cout << "ERROR::SHADER::BAD_INCLUDE: " << line << std::endl;
+                    continue;
+                }
+                fs::path includePath = directory / line.substr(open + 1, close - open - 1);
+                std::ifstream includeFile(includePath);
+                if (!includeFile)
+                {
+                    std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << includePath.string() << std::endl;
+                    continue;
+                }
+                std::stringstream includeStream;
+                includeStream << includeFile.rdbuf();
+                result << expandIncludes(includeStream.str(), includePath.parent_path(), depth + 1) << "\n";
+            }
+            else
+            {
+                result << line << "\n";
+            }
+        }
+        return result.str();
+    }
+
+    // inserts a #define for every constant right after the #version line
+    static std::string injectDefines(const std::string& source, const std::vector<ShaderConstant>& constants)
+    {
+        if (constants.empty())
+            return source;
+        std::ostringstream defines;
+        defines << std::showpoint << std::setprecision(9);
+        for (const ShaderConstant& constant : constants)
+            defines << "#define " << constant.name << " " << constant.value << "\n";
+
+        size_t insertAt = 0;
+        size_t version = source.find("#version");
+        if (version != std::string::npos)
+        {
+            size_t lineEnd = source.find('\n', version);
+            insertAt = lineEnd == std::string::npos ? source.size() : lineEnd + 1;
+        }
+        std::string result = source;
+        if (insertAt > 0 && result[insertAt - 1] != '\n')
+        {
+            result.insert(insertAt, "\n");
+            insertAt++;
+        }
+        result.insert(insertAt, defines.str());
+        return result;
+    }
+
+    // reads a SPIR-V module; returns an empty vector if it is missing or malformed
+    static std::vector<uint32_t> readSpirv(const std::string& path)
+    {
+        const uint32_t SPIRV_MAGIC = 0x07230203;
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (!file)
+            return {};
+        std::streamsize size = file.tellg();
+        if (size < 20 || size % 4 != 0)
+            return {};
+        std::vector<uint32_t> words(size / 4);
+        file.seekg(0);
+        if (!file.read(reinterpret_cast<char*>(words.data()), size) || words[0] != SPIRV_MAGIC)
+            return {};
+        return words;
+    }
+
+    // collects the SpecId decorations declared by a module
+    static std::vector<unsigned int> spirvSpecIds(const std::vector<uint32_t>& words)
+    {
+        const uint32_t OP_DECORATE = 71;
+        const uint32_t DECORATION_SPEC_ID = 1;
+        std::vector<unsigned int> ids;
+        // the header is 5 words; each instruction starts with (wordCount << 16 | opcode)
+        for (size_t i = 5; i < words.size();)
+        {
+            uint32_t wordCount = words[i] >> 16;
+            uint32_t opcode = words[i] & 0xFFFF;
+            if (wordCount == 0)
+                break;
+            if (opcode == OP_DECORATE && wordCount >= 4 && i + 3 < words.size()
+                && words[i + 2] == DECORATION_SPEC_ID)
+                ids.push_back(words[i + 3]);
+            i += wordCount;
+        }
+        return ids;
+    }
+
+    // creates a shader stage from a SPIR-V module; returns 0 on failure
+    static unsigned int specialize(GLenum stage, const std::vector<uint32_t>& words,
+                                   const std::vector<ShaderConstant>& constants, const std::string& type)
+    {
+        // glSpecializeShader rejects ids the module does not declare, so only pass its own
+        std::vector<unsigned int> declared = spirvSpecIds(words);
+        std::vector<GLuint> ids;
+        std::vector<GLuint> values;
+        for (const ShaderConstant& constant : constants)
+        {
+            for (unsigned int id : declared)
+            {
+                if (id != constant.id)
+                    continue;
+                GLuint bits;
+                std::memcpy(&bits, &constant.value, sizeof(bits));
+                ids.push_back(constant.id);
+                values.push_back(bits);
+                break;
+            }
+        }
+
+        unsigned int shader = glCreateShader(stage);
+        glShaderBinary(1, &shader, GL_SHADER_BINARY_FORMAT_SPIR_V,
+                       words.data(), (GLsizei)(words.size() * sizeof(uint32_t)));
+        if (GLAD_GL_VERSION_4_6)
+            glSpecializeShader(shader, "main", (GLuint)ids.size(), ids.data(), values.data());
+        else
+            glSpecializeShaderARB(shader, "main", (GLuint)ids.size(), ids.data(), values.data());
+
+        int success;
+        glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+        if (!success)
+        {
+            checkCompileErrors(shader, type);
+            glDeleteShader(shader);
+            return 0;
+        }
+        return shader;
+    }
+
     // utility function for checking shader compilation/linking errors.
-    void checkCompileErrors(unsigned int shader, std::string type)
+    static void checkCompileErrors(unsigned int shader, std::string type)
     {
         int success;
         char infoLog[1024];
@@ -147,4 +434,34 @@ private:
         }
     }
 };
-#endif  // SHADER_H
\ No newline at end of file
+
+// A Shader that deletes its program when it goes out of scope
+class Program : public Shader
+{
+public:
+    explicit Program(Shader&& shader) : Shader(std::move(shader))
+    {
+        shader.ID = 0;
+    }
+
+    Program(const Program&) = delete;
+    Program& operator=(const Program&) = delete;
+
+    Program(Program&& other) noexcept : Shader(std::move(other))
+    {
+        other.ID = 0;
+    }
+
+    Program& operator=(Program&& other) noexcept
+    {
+        std::swap(static_cast<Shader&>(*this), static_cast<Shader&>(other));
+        return *this;
+    }
+
+    ~Program()
+    {
+        if (ID != 0)
+            terminate();
+    }
+};
+#endif  // SHADER_H
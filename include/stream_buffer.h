@@ -0,0 +1,144 @@
+#ifndef STREAM_BUFFER_H
+#define STREAM_BUFFER_H
+
+#include <glad.h>
+
+#include <vector>
+
+#include <gl_resources.h>
+
+// How a StreamBuffer reaches the GPU
+enum BufferStrategy
+{
+    BUFFER_PERSISTENT = 0,      // persistently mapped where the context allows, else BUFFER_SUBDATA
+    BUFFER_SUBDATA = 1,         // a staging copy uploaded with glBufferSubData
+};
+
+inline const char* bufferStrategyName(BufferStrategy strategy)
+{
+    return strategy == BUFFER_SUBDATA ? "subdata" : "persistent";
+}
+
+/**
+ * Ring of equally sized regions in one buffer, rewritten by the CPU every frame.
+ *
+ * With GL 4.4 (or GL_ARB_buffer_storage) the buffer is created with glBufferStorage
+ * and stays persistently and coherently mapped: begin() returns a pointer straight
+ * into the next region and end() has nothing to do. A fence per region keeps the
+ * CPU from writing a region the GPU may still read, so with three regions the CPU
+ * fills frame N + 2 while the GPU draws frame N. On older contexts begin() returns
+ * a staging copy that end() uploads with glBufferSubData, as does BUFFER_SUBDATA.
+ *
+ * Use once per frame: begin(), write the data, end(), then draw from offset().
+ */
+class StreamBuffer : public Buffer
+{
+public:
+    // regionSize is rounded up to a multiple of alignment (e.g. the uniform buffer offset alignment)
+    StreamBuffer(GLsizeiptr regionSize, int regions = 3, GLsizeiptr alignment = 1,
+                 BufferStrategy strategy = BUFFER_PERSISTENT)
+        : regions(regions), fences(regions, (GLsync)0)
+    {
+        if (alignment < 1)
+            alignment = 1;
+        stride = (regionSize + alignment - 1) / alignment * alignment;
+
+        persistent = strategy == BUFFER_PERSISTENT && (GLAD_GL_VERSION_4_4 || GLAD_GL_ARB_buffer_storage);
+        if (persistent)
+        {
+            const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            storage(stride * regions, NULL, flags);
+            mapped = static_cast<char*>(map(0, stride * regions, flags));
+            persistent = mapped != nullptr;
+        }
+        if (!persistent)
+        {
+            data(stride * regions, NULL, GL_DYNAMIC_DRAW);
+            staging.resize(stride);
+        }
+    }
+
+    StreamBuffer(const StreamBuffer&) = delete;
+    StreamBuffer& operator=(const StreamBuffer&) = delete;
+
+    ~StreamBuffer()
+    {
+        for (GLsync fence : fences)
+        {
+            if (fence)
+                glDeleteSync(fence);
+        }
+        if (persistent)
+            unmap();
+    }
+
+    // true when writes go straight to GPU-visible memory
+    bool isPersistent() const
+    {
+        return persistent;
+    }
+
+    /**
+     * Moves to the next region and returns where to write it. Everything queued
+     * since the previous begin() is assumed to read the previous region, which is
+     * fenced here; the new region is waited on if the GPU has not finished it.
+     */
+    void* begin()
+    {
+        if (written >= 0)
+        {
+            if (fences[written])
+                glDeleteSync(fences[written]);
+            fences[written] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        }
+
+        current = (written + 1) % regions;
+        if (!persistent)
+            return staging.data();
+        waitFor(current);
+        return mapped + current * stride;
+    }
+
+    // Publishes the region written since begin()
+    void end()
+    {
+        if (!persistent)
+            subData(offset(), (GLsizeiptr)staging.size(), staging.data());
+        written = current;
+    }
+
+    // byte offset of the region last returned by begin()
+    GLintptr offset() const
+    {
+        return (GLintptr)current * stride;
+    }
+
+    GLsizeiptr regionSize() const
+    {
+        return stride;
+    }
+
+private:
+    int regions;
+    GLsizeiptr stride = 0;
+    char* mapped = nullptr;
+    bool persistent = false;
+    std::vector<char> staging;
+    std::vector<GLsync> fences;
+    int written = -1;       // region published last, -1 before the first frame
+    int current = 0;
+
+    // blocks until the GPU has finished the frame that last used the region
+    void waitFor(int region)
+    {
+        if (!fences[region])
+            return;
+        GLenum result = glClientWaitSync(fences[region], GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+        while (result == GL_TIMEOUT_EXPIRED)
+            result = glClientWaitSync(fences[region], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);     // 1 ms
+        glDeleteSync(fences[region]);
+        fences[region] = 0;
+    }
+};
+
+#endif  // STREAM_BUFFER_H
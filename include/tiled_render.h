@@ -0,0 +1,173 @@
+#ifndef TILED_RENDER_H
+#define TILED_RENDER_H
+
+#include <glad.h>
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <system_error>
+
+#include <filesystem>
+namespace fs = std::filesystem;
+
+// One tile of a poster, in poster pixels with the origin at the bottom left
+struct Tile
+{
+    int x, y, width, height;
+};
+
+/**
+ * Splits an image too large for one framebuffer (a 32k x 32k poster) into tiles
+ * rendered one after another into a single square framebuffer.
+ *
+ * As in the window, the scene fills the largest centered square of the poster.
+ * projection() maps the part of clip space a tile covers onto the whole tile
+ * framebuffer, so each tile is an ordinary frame drawn with an extra matrix.
+ *
+ * Points are clipped by their center, so a point just outside a tile would vanish
+ * from it while still covering some of its pixels. The tile framebuffer therefore
+ * extends `margin` pixels beyond the tile on every side (half the largest point)
+ * and only the inner tile is kept.
+ */
+class TileLayout
+{
+public:
+    int width, height;      // of the poster
+    int tileSize, margin;
+
+    TileLayout(int width, int height, int tileSize, int margin)
+        : width(width), height(height), tileSize(tileSize), margin(margin)
+    {
+        columns = (width + tileSize - 1) / tileSize;
+        rows = (height + tileSize - 1) / tileSize;
+    }
+
+    // Largest tile the context can render with the given margin, at most `preferred`
+    static int maxTileSize(int preferred, int margin)
+    {
+        int renderbufferSize = 0, viewportSize[2] = {0, 0};
+        glGetIntegerv(GL_MAX_RENDERBUFFER_SIZE, &renderbufferSize);
+        glGetIntegerv(GL_MAX_VIEWPORT_DIMS, viewportSize);
+        int limit = std::min(renderbufferSize, std::min(viewportSize[0], viewportSize[1]));
+        return std::max(1, std::min(preferred, limit - 2 * margin));
+    }
+
+    // Largest gl_PointSize the context draws; larger sizes are clamped
+    static float maxPointSize()
+    {
+        float range[2] = {1.0f, 1.0f};
+        glGetFloatv(GL_POINT_SIZE_RANGE, range);
+        return range[1];
+    }
+
+    int count() const
+    {
+        return columns * rows;
+    }
+
+    // Tiles go left to right, bottom to top; edge tiles are cut to the poster
+    Tile tile(int index) const
+    {
+        Tile tile;
+        tile.x = (index % columns) * tileSize;
+        tile.y = (index / columns) * tileSize;
+        tile.width = std::min(tileSize, width - tile.x);
+        tile.height = std::min(tileSize, height - tile.y);
+        return tile;
+    }
+
+    // Side of the square tile framebuffer; the tile sits at (margin, margin)
+    int framebufferSize() const
+    {
+        return tileSize + 2 * margin;
+    }
+
+    // Applied after the scene's projection: the tile and its margin fill clip space
+    glm::mat4 projection(const Tile& tile) const
+    {
+        const float side = (float)std::min(width, height);
+        const float originX = (width - side) / 2.0f - (tile.x - margin);
+        const float originY = (height - side) / 2.0f - (tile.y - margin);
+        const float size = (float)framebufferSize();
+
+        glm::mat4 matrix(1.0f);
+        matrix[0][0] = side / size;
+        matrix[1][1] = side / size;
+        matrix[3][0] = (side + 2.0f * originX) / size - 1.0f;
+        matrix[3][1] = (side + 2.0f * originY) / size - 1.0f;
+        return matrix;
+    }
+
+private:
+    int columns, rows;
+};
+
+/**
+ * Binary PPM written tile by tile. The file is sized up front and each tile's
+ * rows are written straight to their place in it, so only one tile is ever held
+ * in memory, whatever the size of the image.
+ */
+class TiledImageWriter
+{
+public:
+    TiledImageWriter(const std::string& path, int width, int height)
+        : path(path), width(width), height(height)
+    {
+        std::ofstream header(path, std::ios::binary | std::ios::trunc);
+        header << "P6\n" << width << " " << height << "\n255\n";
+        headerSize = header.tellp();
+        header.close();
+
+        std::error_code error;
+        fs::resize_file(path, (std::uintmax_t)headerSize + (std::uintmax_t)width * height * 3, error);
+        if (!header || error)
+        {
+            std::cerr << "ERROR::TILED_IMAGE::CANNOT_WRITE " << path << std::endl;
+            return;
+        }
+        file.open(path, std::ios::binary | std::ios::in | std::ios::out);
+    }
+
+    bool valid() const
+    {
+        return file.is_open() && file.good();
+    }
+
+    // Stores a tile's RGB pixels, tightly packed and bottom row first as glReadPixels returns them
+    bool write(const Tile& tile, const unsigned char* rgb)
+    {
+        const size_t stride = (size_t)tile.width * 3;
+        for (int row = 0; row < tile.height; row++)
+        {
+            // the PPM starts at the top row
+            const std::streamoff line = height - 1 - (tile.y + row);
+            file.seekp(headerSize + (line * width + tile.x) * 3);
+            file.write((const char*)rgb + row * stride, stride);
+        }
+        if (!file)
+        {
+            std::cerr << "ERROR::TILED_IMAGE::WRITE_FAILED " << path << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    bool finish()
+    {
+        file.close();
+        return !file.fail();
+    }
+
+private:
+    std::string path;
+    std::streamoff width, height;
+    std::streamoff headerSize = 0;
+    std::fstream file;
+};
+
+#endif  // TILED_RENDER_H
@@ -0,0 +1,508 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <glad.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// One slice on a timeline; times in nanoseconds of the steady clock
+struct TraceEvent
+{
+    const char* name;       // must outlive the trace, in practice a string literal
+    uint64_t start, end;
+};
+
+/**
+ * Timeline recorder for Chrome's trace viewer (chrome://tracing, ui.perfetto.dev).
+ *
+ * Scopes append one event when they close, into a ring owned by the calling
+ * thread: no lock, and one allocation at the thread's first event. A full ring
+ * overwrites its oldest events, so a long run keeps its latest ones in bounded
+ * memory; write() can read the rings while threads keep recording.
+ * Until start() is called a scope costs one branch.
+ *
+ * GPU scopes bracket their commands with GL_TIMESTAMP queries, read without
+ * waiting once the GPU has passed them and placed on a separate "GPU" track
+ * with the clocks aligned, so CPU/GPU overlap and stalls line up.
+ *
+ * write() produces Chrome trace JSON, or Perfetto protobuf for paths ending in
+ * .pftrace or .perfetto-trace.
+ */
+class Trace
+{
+public:
+    static const size_t DEFAULT_EVENTS = 1 << 20;      // per thread, 24 MB
+
+    // Each thread keeps its latest eventsPerThread events; earlier ones are dropped
+    // and counted. The size applies to threads that have not recorded yet
+    static void start(size_t eventsPerThread = DEFAULT_EVENTS)
+    {
+        capacity.store(std::max<size_t>(eventsPerThread, 1), std::memory_order_relaxed);
+        recording.store(true, std::memory_order_relaxed);
+    }
+
+    // Scopes closing after this are not recorded; what was recorded stays
+    static void stop()
+    {
+        recording.store(false, std::memory_order_relaxed);
+    }
+
+    static bool enabled()
+    {
+        return recording.load(std::memory_order_relaxed);
+    }
+
+    static uint64_t now()
+    {
+        using clock = std::chrono::steady_clock;
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now().time_since_epoch()).count();
+    }
+
+    static void record(const char* name, uint64_t start, uint64_t end)
+    {
+        append(local(), {name, start, end});
+    }
+
+    // Names the calling thread's track
+    static void setThreadName(const std::string& name)
+    {
+        ThreadBuffer& buffer = local();
+        std::lock_guard<std::mutex> lock(registryMutex);
+        buffer.name = name;
+    }
+
+    // Issues the GPU timestamp that opens a GPU scope; returns its query
+    static unsigned int beginGpu()
+    {
+        if (!calibrated)
+        {
+            // GL timestamps count from an arbitrary origin
+            GLint64 gpuNow = 0;
+            glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+            gpuOffset = (int64_t)now() - (int64_t)gpuNow;
+            calibrated = true;
+        }
+        unsigned int query = nextQuery();
+        glQueryCounter(query, GL_TIMESTAMP);
+        return query;
+    }
+
+    static void endGpu(const char* name, unsigned int beginQuery)
+    {
+        unsigned int endQuery = nextQuery();
+        glQueryCounter(endQuery, GL_TIMESTAMP);
+        pendingGpu.push_back({name, beginQuery, endQuery});
+    }
+
+    // Moves the GPU scopes the GPU has finished onto the GPU track; never waits.
+    // Call once a frame on the GL thread
+    static void collectGpu()
+    {
+        size_t done = 0;
+        for (; done < pendingGpu.size(); done++)
+        {
+            const PendingGpu& pending = pendingGpu[done];
+            GLint available = 0;
+            glGetQueryObjectiv(pending.end, GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available)
+                break;
+            GLuint64 begin = 0, end = 0;
+            glGetQueryObjectui64v(pending.begin, GL_QUERY_RESULT, &begin);
+            glGetQueryObjectui64v(pending.end, GL_QUERY_RESULT, &end);
+            append(gpuTrack(), {pending.name, (uint64_t)(begin + gpuOffset), (uint64_t)(end + gpuOffset)});
+            freeQueries.push_back(pending.begin);
+            freeQueries.push_back(pending.end);
+        }
+        pendingGpu.erase(pendingGpu.begin(), pendingGpu.begin() + done);
+    }
+
+    // A "frame" event from here to endFrame(), on the calling thread
+    static void beginFrame()
+    {
+        if (!enabled())
+            return;
+        collectGpu();
+        frameStart = now();
+    }
+
+    static void endFrame()
+    {
+        if (enabled())
+            record("frame", frameStart, now());
+    }
+
+    // Writes every event recorded so far; returns false if the file cannot be written
+    static bool write(const std::string& path)
+    {
+        std::vector<Track> tracks = snapshot();
+        const bool perfetto = endsWith(path, ".pftrace") || endsWith(path, ".perfetto-trace");
+        std::string output = perfetto ? perfettoTrace(tracks) : chromeTrace(tracks);
+
+        FILE* file = fopen(path.c_str(), "wb");
+        if (file == NULL)
+        {
+            fprintf(stderr, "ERROR::TRACE::CANNOT_WRITE %s\n", path.c_str());
+            return false;
+        }
+        bool written = fwrite(output.data(), 1, output.size(), file) == output.size();
+        return fclose(file) == 0 && written;
+    }
+
+    // Deletes the GPU queries; call while the context is current
+    static void terminate()
+    {
+        for (const PendingGpu& pending : pendingGpu)
+        {
+            freeQueries.push_back(pending.begin);
+            freeQueries.push_back(pending.end);
+        }
+        pendingGpu.clear();
+        if (!freeQueries.empty())
+            glDeleteQueries((GLsizei)freeQueries.size(), freeQueries.data());
+        freeQueries.clear();
+    }
+
+private:
+    struct ThreadBuffer
+    {
+        int id;
+        std::string name;
+        std::unique_ptr<TraceEvent[]> ring;     // allocated by the first event, never moves
+        size_t capacity = 0;                    // events kept; the ring has one more slot, for the one being written
+        std::atomic<size_t> count{0};       // events ever appended, published with release after each
+    };
+
+    struct PendingGpu
+    {
+        const char* name;
+        unsigned int begin, end;
+    };
+
+    // What write() reads of one buffer
+    struct Track
+    {
+        int id;
+        std::string name;
+        std::vector<TraceEvent> events;
+        size_t dropped;                     // overwritten before write() read them
+    };
+
+    static inline std::atomic<bool> recording{false};
+    static inline std::atomic<size_t> capacity{DEFAULT_EVENTS};
+    static inline std::mutex registryMutex;
+    static inline std::vector<std::unique_ptr<ThreadBuffer>> buffers;     // live until exit
+    static inline std::vector<PendingGpu> pendingGpu;
+    static inline std::vector<unsigned int> freeQueries;
+    static inline bool calibrated = false;
+    static inline int64_t gpuOffset = 0;
+    static inline uint64_t frameStart = 0;
+
+    static ThreadBuffer& registerBuffer(const std::string& name)
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        buffers.push_back(std::make_unique<ThreadBuffer>());
+        buffers.back()->id = (int)buffers.size();
+        buffers.back()->name = name;
+        return *buffers.back();
+    }
+
+    static ThreadBuffer& local()
+    {
+        thread_local ThreadBuffer& buffer = registerBuffer("thread");
+        return buffer;
+    }
+
+    static ThreadBuffer& gpuTrack()
+    {
+        static ThreadBuffer& buffer = registerBuffer("GPU");
+        return buffer;
+    }
+
+    // Only the owning thread appends, so a relaxed read of its own count is enough.
+    // The ring and its capacity are set before the first count is published
+    static void append(ThreadBuffer& buffer, const TraceEvent& event)
+    {
+        const size_t index = buffer.count.load(std::memory_order_relaxed);
+        if (index == 0)
+        {
+            buffer.capacity = capacity.load(std::memory_order_relaxed);
+            buffer.ring.reset(new TraceEvent[buffer.capacity + 1]);
+        }
+        buffer.ring[index % (buffer.capacity + 1)] = event;
+        buffer.count.store(index + 1, std::memory_order_release);
+    }
+
+    static unsigned int nextQuery()
+    {
+        unsigned int query;
+        if (freeQueries.empty())
+        {
+            glGenQueries(1, &query);
+            return query;
+        }
+        query = freeQueries.back();
+        freeQueries.pop_back();
+        return query;
+    }
+
+    static std::vector<Track> snapshot()
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        std::vector<Track> tracks;
+        for (const std::unique_ptr<ThreadBuffer>& buffer : buffers)
+        {
+            const size_t count = buffer->count.load(std::memory_order_acquire);
+            Track track = {buffer->id, buffer->name, {}, 0};
+            if (count > 0)
+            {
+                const size_t kept = buffer->capacity;
+                const size_t first = count > kept ? count - kept : 0;
+                track.events.reserve(count - first);
+                for (size_t i = first; i < count; i++)
+                    track.events.push_back(buffer->ring[i % (kept + 1)]);
+
+                // The owner may have wrapped around meanwhile: appending event n
+                // overwrites event n - kept - 1, so only the later ones are intact
+                std::atomic_thread_fence(std::memory_order_acquire);
+                const size_t later = buffer->count.load(std::memory_order_relaxed);
+                const size_t intact = later > kept ? later - kept : 0;
+                const size_t overwritten = intact > first ? std::min(intact - first, track.events.size()) : 0;
+                track.events.erase(track.events.begin(), track.events.begin() + overwritten);
+                track.dropped = first + overwritten;
+            }
+            tracks.push_back(std::move(track));
+        }
+        return tracks;
+    }
+
+    static bool endsWith(const std::string& text, const std::string& suffix)
+    {
+        return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+    }
+
+    static std::string jsonString(const std::string& text)
+    {
+        std::string quoted = "\"";
+        for (char c : text)
+        {
+            if (c == '"' || c == '\\')
+                quoted += '\\';
+            quoted += (unsigned char)c < 0x20 ? ' ' : c;
+        }
+        return quoted + "\"";
+    }
+
+    // Complete ("X") events in microseconds, plus one thread_name record per track
+    static std::string chromeTrace(const std::vector<Track>& tracks)
+    {
+        uint64_t origin = earliest(tracks);
+        std::string json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+        char line[512];
+        bool first = true;
+        for (const Track& track : tracks)
+        {
+            std::string name = track.name;
+            if (track.dropped > 0)
+                name += " (" + std::to_string(track.dropped) + " earlier events dropped)";
+            snprintf(line, sizeof(line), "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":%s}}",
+                     first ? "" : ",\n", track.id, jsonString(name).c_str());
+            json += line;
+            first = false;
+            for (const TraceEvent& event : track.events)
+            {
+                snprintf(line, sizeof(line), ",\n{\"name\":%s,\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                         jsonString(event.name).c_str(), track.id,
+                         (event.start - origin) / 1000.0, (event.end - event.start) / 1000.0);
+                json += line;
+            }
+        }
+        return json + "\n]}\n";
+    }
+
+    static uint64_t earliest(const std::vector<Track>& tracks)
+    {
+        uint64_t origin = UINT64_MAX;
+        for (const Track& track : tracks)
+        {
+            for (const TraceEvent& event : track.events)
+                origin = std::min(origin, event.start);
+        }
+        return origin == UINT64_MAX ? 0 : origin;
+    }
+
+    // Protobuf encoding of the few perfetto.protos.Trace fields used here
+    static void varint(std::string& out, uint64_t value)
+    {
+        while (value >= 0x80)
+        {
+            out += (char)(value | 0x80);
+            value >>= 7;
+        }
+        out += (char)value;
+    }
+
+    static void field(std::string& out, int number, uint64_t value)
+    {
+        varint(out, (uint64_t)number << 3);
+        varint(out, value);
+    }
+
+    static void field(std::string& out, int number, const std::string& bytes)
+    {
+        varint(out, (uint64_t)number << 3 | 2);
+        varint(out, bytes.size());
+        out += bytes;
+    }
+
+    // A TracePacket (Trace.packet = 1) on sequence 1
+    static void packet(std::string& out, const std::string& body, bool first)
+    {
+        std::string packet = body;
+        field(packet, 10, 1);           // trusted_packet_sequence_id
+        if (first)
+            field(packet, 13, 1);       // sequence_flags: SEQ_INCREMENTAL_STATE_CLEARED
+        field(out, 1, packet);
+    }
+
+    // A slice boundary, as a finished packet waiting to be put in time order
+    struct Boundary
+    {
+        uint64_t timestamp;
+        std::string packet;
+    };
+
+    static void slice(std::vector<Boundary>& out, uint64_t timestamp, int type, uint64_t track, const char* name)
+    {
+        std::string event;
+        field(event, 9, type);          // TrackEvent.type: SLICE_BEGIN = 1, SLICE_END = 2
+        field(event, 11, track);        // track_uuid
+        if (name != NULL)
+            field(event, 23, std::string(name));
+        std::string body;
+        field(body, 8, timestamp);      // TracePacket.timestamp
+        field(body, 11, event);         // track_event
+        out.push_back({timestamp, std::string()});
+        packet(out.back().packet, body, false);
+    }
+
+    // One TrackDescriptor per track, then every slice as a begin/end pair, in time order
+    static std::string perfettoTrace(const std::vector<Track>& tracks)
+    {
+        std::string out;
+        bool first = true;
+        for (const Track& track : tracks)
+        {
+            std::string thread;
+            field(thread, 1, 1);                    // ThreadDescriptor.pid
+            field(thread, 2, track.id);             // tid
+            field(thread, 5, track.name);           // thread_name
+            std::string descriptor;
+            field(descriptor, 1, track.id);         // TrackDescriptor.uuid
+            field(descriptor, 4, thread);           // thread
+            std::string body;
+            field(body, 60, descriptor);            // TracePacket.track_descriptor
+            packet(out, body, first);
+            first = false;
+        }
+
+        std::vector<Boundary> boundaries;
+        for (const Track& track : tracks)
+        {
+            // events are stored as they close, children first; slices must open in order
+            std::vector<TraceEvent> events = track.events;
+            std::sort(events.begin(), events.end(), [](const TraceEvent& a, const TraceEvent& b) {
+                return a.start != b.start ? a.start < b.start : a.end > b.end;
+            });
+            std::vector<uint64_t> open;
+            for (const TraceEvent& event : events)
+            {
+                while (!open.empty() && open.back() <= event.start)
+                {
+                    slice(boundaries, open.back(), 2, track.id, NULL);
+                    open.pop_back();
+                }
+                slice(boundaries, event.start, 1, track.id, event.name);
+                open.push_back(event.end);
+            }
+            while (!open.empty())
+            {
+                slice(boundaries, open.back(), 2, track.id, NULL);
+                open.pop_back();
+            }
+        }
+
+        // stable, so each track keeps its own order where timestamps are equal
+        std::stable_sort(boundaries.begin(), boundaries.end(), [](const Boundary& a, const Boundary& b) {
+            return a.timestamp < b.timestamp;
+        });
+        for (const Boundary& boundary : boundaries)
+            out += boundary.packet;
+        return out;
+    }
+};
+
+// Records the enclosing block as one event on the calling thread's track
+class TraceScope
+{
+public:
+    explicit TraceScope(const char* name) : name(name), active(Trace::enabled())
+    {
+        if (active)
+            start = Trace::now();
+    }
+
+    ~TraceScope()
+    {
+        if (active)
+            Trace::record(name, start, Trace::now());
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* name;
+    bool active;
+    uint64_t start = 0;
+};
+
+// The same on the GPU track, for the GL commands issued inside the block
+class TraceGpuScope
+{
+public:
+    explicit TraceGpuScope(const char* name) : name(name), active(Trace::enabled())
+    {
+        if (active)
+            query = Trace::beginGpu();
+    }
+
+    ~TraceGpuScope()
+    {
+        if (active)
+            Trace::endGpu(name, query);
+    }
+
+    TraceGpuScope(const TraceGpuScope&) = delete;
+    TraceGpuScope& operator=(const TraceGpuScope&) = delete;
+
+private:
+    const char* name;
+    bool active;
+    unsigned int query = 0;
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(traceScope, __LINE__)(name)
+#define TRACE_GPU_SCOPE(name) TraceScope TRACE_CONCAT(traceScope, __LINE__)(name); \
+                              TraceGpuScope TRACE_CONCAT(traceGpuScope, __LINE__)(name)
+
+#endif  // TRACE_H
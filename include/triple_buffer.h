@@ -0,0 +1,64 @@
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+#include <atomic>
+
+/**
+ * Hands the latest value from one writer thread to one reader thread without
+ * locks or waiting. The writer fills back() and publishes it; the reader takes
+ * the most recent publication with update() and reads it as front(). Values
+ * published before the reader gets to them are dropped, latest wins.
+ *
+ * Three slots make this work: each side owns one and the third, the middle,
+ * changes hands with one atomic exchange, whose FRESH bit tells the reader
+ * whether the middle holds a value it has not seen.
+ */
+template <typename T>
+class TripleBuffer
+{
+public:
+    // The writer's slot; it keeps whatever was in it, so fill it completely
+    T& back()
+    {
+        return slots[backIndex];
+    }
+
+    // Makes back() the latest value and hands the writer another slot
+    void publish()
+    {
+        int previous = middle.exchange(backIndex | FRESH, std::memory_order_acq_rel);
+        backIndex = previous & INDEX;
+    }
+
+    // True when a value was published since the reader's last update()
+    bool fresh() const
+    {
+        return (middle.load(std::memory_order_acquire) & FRESH) != 0;
+    }
+
+    // Takes the latest value into front(); false, and front() unchanged, if there is none
+    bool update()
+    {
+        if (!fresh())
+            return false;
+        int previous = middle.exchange(frontIndex, std::memory_order_acq_rel);
+        frontIndex = previous & INDEX;
+        return true;
+    }
+
+    const T& front() const
+    {
+        return slots[frontIndex];
+    }
+
+private:
+    static const int INDEX = 3;
+    static const int FRESH = 4;
+
+    T slots[3] = {};
+    std::atomic<int> middle{1};
+    int backIndex = 0;      // the writer's
+    int frontIndex = 2;     // the reader's
+};
+
+#endif  // TRIPLE_BUFFER_H
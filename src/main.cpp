@@ -13,96 +13,100 @@
 #include <glm/gtx/string_cast.hpp>      // For print vectors and matrices
 
 #include <random>
-#include <shader.h>
+#include <algorithm>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <memory>
+#include <condition_variable>
+#include <point_sphere.h>
+#include <generator.h>
+#include <point_modes.h>
+#include <oit.h>
+#include <frame_constants.h>
+#include <frame_pacer.h>
+#include <arcball.h>
+#include <rotation_state.h>
+#include <settings.h>
+#include <triple_buffer.h>
+#include <frame_readback.h>
+#include <frame_encoder.h>
+#include <tiled_render.h>
+#include <cpu_rasterizer.h>
+#include <profiler.h>
+#include <trace.h>
+#ifdef POINT_SPHERE_EGL
+#include <headless_context.h>
+#endif
 
 #include <filesystem>
 namespace fs = std::filesystem;
 
-#define NUM_POINTS 2000
-#define ESPILON 0.0001
-#define SCALE 0.9
+// While the window is open, the --config file is checked for changes this often, in seconds
+#define SETTINGS_POLL_INTERVAL 0.5
 
-#define HEIGHT 405
-#define WIDTH 440
+// What the window's callbacks update, on the main thread
+struct WindowInput {
+    FramePacer pacer;
+    bool mouseTracking;
+    Arcball arcball;
+    // The drag, for the render thread to take just before it draws
+    TripleBuffer<ArcballSample> arcballSamples;
 
-// Set to 1 to enable mouse tracking
-#define MOUSE_TRACKING 0
+    WindowInput(const FramePacer& pacer, bool mouseTracking) : pacer(pacer), mouseTracking(mouseTracking) {}
 
-// w is only used for debugging purposes; it is always 1.0
-typedef struct {
-    float x, y;
-} vec2local;
-
-typedef struct {
-    float x, y, z;
-} vec3local;
-
-vec3local points3D[NUM_POINTS];
-
-/**
- * Populates the 2D array of points using the formula
- * Derived from this paper: https://scholar.rose-hulman.edu/cgi/viewcontent.cgi?article=1387&context=rhumj
- * 
- * @param points2D The 2D array of points to populate
- * @see #populate3Darray()
- */
-
-void populate2Darray(vec2local * points2D) {
-    float s = -1 + 1.0f /(NUM_POINTS - 1);
-    const float step_size = (2.0f - 2.0f/(NUM_POINTS - 1))/(NUM_POINTS - 1);
-    const float x = 0.1 + 1.2 * NUM_POINTS;
-
-    for (int i = 0; i < NUM_POINTS; i++, s += step_size) {
-        points2D[i].x = s * x;
-        points2D[i].y = M_PI/2 * copysignf(1.0f, s) * (1 - sqrt(1 - abs(s)));
+    void publishDrag() {
+        arcballSamples.back() = arcball.sample();
+        arcballSamples.publish();
     }
-} /* populate2Darray() */
+};
 
 /**
- * Calculates the 3D coordinates from the 2D projection of the spiral
- * Uses the {@link #populate2Darray(TwoDPoint *)} function to create the 2D array
- * of points.
+ * Callback function: anything that changes what the window shows
+ * Makes the frame pacer draw the next frame at once
  */
+void invalidate_callback(GLFWwindow* window) {
+    static_cast<WindowInput*>(glfwGetWindowUserPointer(window))->pacer.invalidate();
+} /* invalidate_callback() */
 
-void populate3Darray() {
-    vec2local points2D[NUM_POINTS];
-    populate2Darray(points2D);
-    for (int i = 0; i < NUM_POINTS; i++) {
-        float u = points2D[i].x;
-        float v = points2D[i].y;
-
-        points3D[i].x = SCALE * cos(u) * cos(v);
-        points3D[i].y = SCALE * sin(u) * cos(v);
-        points3D[i].z = SCALE * sin(v);
-    }
-} /* populate3Darray() */
-
-void populate3Drand() {
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_real_distribution<float> dis(-180.0, 180.0);
-
+void framebuffer_size_callback(GLFWwindow* window, int, int) {
+    invalidate_callback(window);
+} /* framebuffer_size_callback() */
 
-    float dist = 200.0;
-    for (int i = 0; i < NUM_POINTS; i++) {
-        double theta = dis(gen);
-        double phi = dis(gen);
+void key_callback(GLFWwindow* window, int, int, int, int) {
+    invalidate_callback(window);
+} /* key_callback() */
 
-        points3D[i].x = SCALE * sin(theta) * cos(phi);
-        points3D[i].y = SCALE * sin(theta) * sin(phi);
-        points3D[i].z = SCALE * cos(theta);
+void cursor_position_callback(GLFWwindow* window, double x, double y) {
+    WindowInput* input = static_cast<WindowInput*>(glfwGetWindowUserPointer(window));
+    if (input->mouseTracking && input->arcball.dragging()) {
+        input->arcball.drag(x, y, glfwGetTime());
+        input->publishDrag();
+        input->pacer.invalidate();
     }
-}
+} /* cursor_position_callback() */
 
-/**
- * Callback function: window resize
- */
-void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
-    int min = width < height ? width : height;
-    int xOffset = (width - min) / 2;
-    int yOffset = (height - min) / 2;
-    glViewport(xOffset, yOffset, min, min);
-} /* framebuffer_size_callback() */
+void mouse_button_callback(GLFWwindow* window, int button, int action, int) {
+    if (button != GLFW_MOUSE_BUTTON_LEFT) {
+        return;
+    }
+    WindowInput* input = static_cast<WindowInput*>(glfwGetWindowUserPointer(window));
+    double x, y;
+    glfwGetCursorPos(window, &x, &y);
+    if (action == GLFW_PRESS) {
+        if (!input->mouseTracking) {
+            return;
+        }
+        int width, height;
+        glfwGetWindowSize(window, &width, &height);
+        input->arcball.resize(width, height);
+        input->arcball.press(x, y, glfwGetTime());
+    } else {
+        input->arcball.release(glfwGetTime());
+    }
+    input->publishDrag();
+    input->pacer.invalidate();
+} /* mouse_button_callback() */
 
 /**
  * Callback function: Keyboard input
@@ -114,142 +118,653 @@ void process_input(GLFWwindow *window) {
 } /* processInput() */
 
 /**
- * Main function
- * Create and manage the window
+ * Renders the frames of a --headless run without any GL context, on the CPU
+ * rasterizer, for machines without a GPU. Points are drawn as hard-edged circles
+ * (or squares in POINT_MODE_SQUARE) and only the single sphere is drawn.
+ *
+ * @param config The sphere
+ * @param width The image width
+ * @param height The image height
+ * @param frames The number of frames; the last one is written to outputPath
+ * @param outputPath A PPM file, or empty
+ * @param exportPath Every frame, as for --export, or empty
  */
+int renderCpu(const PointSphereConfig& config, int width, int height, int frames,
+              const std::string& outputPath, const std::string& exportPath) {
+    if (pointModeBlends(config.pointMode) || pointModeNeedsMultisample(config.pointMode)) {
+        std::cerr << "The CPU rasterizer draws " << pointModeName(config.pointMode) << " points as hard-edged circles" << std::endl;
+    }
+    std::vector<vec3local> points(config.numPoints), displaced;
+    if (config.generator == POINT_GENERATOR_RANDOM) {
+        populate3Drand(points.data(), config.numPoints, config.scale, config.seed);
+    } else {
+        populate3Darray(points.data(), config.numPoints, config.scale);
+    }
+    if (config.animated) {
+        displaced.resize(config.numPoints);
+    }
 
-int main(int argc, char* argv[]) {
-    // Seed the random number generator
-    srand(1);
+    CpuRasterizer rasterizer(width, height);
+    rasterizer.setConstants(config.shaderConstants());
+    rasterizer.roundPoints = config.pointMode != POINT_MODE_SQUARE;
+    int viewportSize = std::min(width, height);
+    rasterizer.setViewport((width - viewportSize) / 2, (height - viewportSize) / 2, viewportSize, viewportSize);
+
+    FrameEncoder * encoder = NULL;
+    if (!exportPath.empty()) {
+        encoder = new FrameEncoder(exportPath, width, height);
+        if (!encoder->valid()) {
+            delete encoder;
+            return 1;
+        }
+    }
 
-    GLFWwindow * window = NULL;
-    if (!glfwInit()) {
-        std::cerr << "Issue with inializing glfw" << std::endl;
-        return -1;
+    #ifdef SIGUSR1
+    PROFILE_REPORT_ON_SIGNAL(SIGUSR1);
+    #endif
+    FrameConstants frameConstants;
+    RotationState rotation(glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::normalize(glm::vec3(-2, 3, 1)) * config.rotationSpeed);
+    for (int frame = 0; frame < frames; frame++) {
+        PROFILE_FRAME_BEGIN();
+        // The same rotation as the GL loop's headless frames
+        float time = frame / 60.0f;
+        rotation.integrate(time - frameConstants.time.x);
+        frameConstants.rotation = glm::mat4(rotation.matrix());
+        frameConstants.time.x = time;
+        if (config.animated) {
+            displacePoints(points.data(), displaced.data(), config.numPoints, time, config.animationAmplitude);
+            rasterizer.render(displaced.data(), config.numPoints, frameConstants);
+        } else {
+            rasterizer.render(points.data(), config.numPoints, frameConstants);
+        }
+        if (encoder != NULL) {
+            PROFILE_SCOPE("export");
+            encoder->submit(reinterpret_cast<const unsigned char*>(rasterizer.pixels()));
+        }
+        PROFILE_FRAME_END();
     }
+    PROFILE_REPORT();
 
-    // Setup OpenGL version (using 3.3)
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    int status = 0;
+    if (encoder != NULL) {
+        encoder->finish();
+        std::cerr << "Exported " << encoder->framesWritten() << " frames to " << exportPath << std::endl;
+        delete encoder;
+    }
+    if (!outputPath.empty()) {
+        std::vector<unsigned char> rgb((size_t)width * height * 3);
+        const unsigned char* rgba = reinterpret_cast<const unsigned char*>(rasterizer.pixels());
+        for (size_t i = 0; i < (size_t)width * height; i++) {
+            rgb[3 * i] = rgba[4 * i];
+            rgb[3 * i + 1] = rgba[4 * i + 1];
+            rgb[3 * i + 2] = rgba[4 * i + 2];
+        }
+        TiledImageWriter image(outputPath, width, height);
+        if (!image.valid() || !image.write({0, 0, width, height}, rgb.data()) || !image.finish()) {
+            status = 1;
+        }
+    }
+    return status;
+} /* renderCpu() */
 
-    window = glfwCreateWindow(WIDTH, HEIGHT, "point-sphere", NULL, NULL);
-    if (window == NULL) {
-        glfwTerminate();
-        std::cerr << "Failed to create GLFW window" << std::endl;
-        return -1;
+/**
+ * Reads the settings file again after it has changed, with the command-line
+ * overrides over it. A setting that needs a new window or context keeps its value,
+ * with a note that it applies on restart; so does a point mode that would switch
+ * multisampling on or off.
+ *
+ * @param settings The current settings, replaced by the reloaded ones
+ * @param path The settings file
+ * @param overrides From the command line
+ * @return true if the file was valid and changed anything that can apply now
+ */
+static bool reloadSettings(Settings& settings, const std::string& path,
+                           const std::vector<std::pair<std::string, std::string>>& overrides) {
+    Settings reloaded;
+    reloaded.sphere.shaderDir = settings.sphere.shaderDir;
+    reloaded.sphere.spirvDir = settings.sphere.spirvDir;
+    reloaded.sphere.pointScale = settings.sphere.pointScale;
+    if (!loadSettings(reloaded, path, overrides)) {
+        std::cerr << "Keeping the previous settings" << std::endl;
+        return false;
     }
-    glfwMakeContextCurrent(window);
 
-    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
-        std::cerr << "Failed to initialize GLAD" << std::endl;
-        glfwTerminate();
-        return -1;
+    bool changed = false;
+    for (const SettingOption& option : settingOptions()) {
+        std::string current = option.get(settings);
+        if (option.get(reloaded) == current) {
+            continue;
+        }
+        bool restart = option.reload == RELOAD_RESTART;
+        if (std::string(option.name) == "point-mode") {
+            restart = pointModeNeedsMultisample(reloaded.sphere.pointMode) != pointModeNeedsMultisample(settings.sphere.pointMode);
+        }
+        if (restart) {
+            std::cerr << "Settings: " << option.name << " = " << option.get(reloaded) << " applies on restart" << std::endl;
+            option.set(reloaded, current);
+        } else {
+            std::cerr << "Settings: " << option.name << " = " << option.get(reloaded) << std::endl;
+            changed = true;
+        }
+    }
+    if (changed) {
+        settings = reloaded;
     }
+    return changed;
+} /* reloadSettings() */
 
-    // Set the viewport to the middle of the window
-    int min = WIDTH < HEIGHT ? WIDTH : HEIGHT;
-    int xOffset = (WIDTH - min) / 2;
-    int yOffset = (HEIGHT - min) / 2;
-    glViewport(xOffset, yOffset, min, min);
+/**
+ * Main function
+ * Create and manage the window
+ *
+ * Usage: point-sphere [--headless [--cpu] [--frames N] [--output frame.ppm] [--poster WxH]] [--size WxH] [--export PATH]
+ *                     [--trace PATH] [--config PATH] [--NAME VALUE ...] [--settings]
+ * --headless renders N frames (1 by default) offscreen through EGL, with no window
+ * or display, and optionally writes the last one to a PPM file.
+ * --cpu renders the headless frames on the CPU rasterizer, with no GL context at all.
+ * --poster renders the last frame at WxH instead, in tiles streamed to the --output file,
+ * with points scaled as if the --size view were enlarged to the poster.
+ * --export writes every frame: "-" streams Y4M to stdout, "*.y4m" writes a Y4M file
+ * and anything else is a pattern for numbered PNGs such as "frames/%05d.png".
+ * --trace records the generation, shader builds, uploads and every frame phase, CPU and
+ * GPU, and writes them on exit for chrome://tracing or ui.perfetto.dev (PATH.pftrace).
+ * --config reads settings from a file of "name = value" lines, and --NAME VALUE sets one
+ * over it; --settings prints them all, with their defaults, as such a file. While the
+ * window is open, changes to the --config file apply without a restart where they can.
+ */
 
-    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);  
+int main(int argc, char* argv[]) {
+    // Seed the random number generator
+    srand(1);
 
-    populate3Darray();
-    // populate3Drand();
+    bool headless = false, cpu = false;
+    int headlessFrames = 1;
+    bool printOnly = false;
+    int posterWidth = 0, posterHeight = 0;
+    std::string outputPath, exportPath, tracePath, configPath;
+    std::vector<std::pair<std::string, std::string>> overrides;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool valid = true;
+        if (arg == "--headless") {
+            headless = true;
+        } else if (arg == "--cpu") {
+            cpu = true;
+        } else if (arg == "--frames" && i + 1 < argc) {
+            headlessFrames = std::max(1, atoi(argv[++i]));
+        } else if (arg == "--size" && i + 1 < argc) {
+            int width, height;
+            valid = sscanf(argv[++i], "%dx%d", &width, &height) == 2 && width > 0 && height > 0;
+            if (valid) {
+                overrides.push_back({"width", std::to_string(width)});
+                overrides.push_back({"height", std::to_string(height)});
+            }
+        } else if (arg == "--poster" && i + 1 < argc) {
+            valid = sscanf(argv[++i], "%dx%d", &posterWidth, &posterHeight) == 2 && posterWidth > 0 && posterHeight > 0;
+        } else if (arg == "--output" && i + 1 < argc) {
+            outputPath = argv[++i];
+        } else if (arg == "--export" && i + 1 < argc) {
+            exportPath = argv[++i];
+        } else if (arg == "--trace" && i + 1 < argc) {
+            tracePath = argv[++i];
+        } else if (arg == "--config" && i + 1 < argc) {
+            configPath = argv[++i];
+        } else if (arg == "--settings") {
+            printOnly = true;
+        } else if (arg.compare(0, 2, "--") == 0 && findSetting(arg.substr(2)) != NULL && i + 1 < argc) {
+            overrides.push_back({arg.substr(2), argv[++i]});
+        } else {
+            valid = false;
+        }
+        if (!valid) {
+            std::cerr << "Usage: " << argv[0] << " [--headless [--cpu] [--frames N] [--output frame.ppm] [--poster WxH]]"
+                      << " [--size WxH] [--export PATH] [--trace PATH] [--config PATH] [--NAME VALUE ...] [--settings]"
+                      << std::endl;
+            return 1;
+        }
+    }
 
-    /*
-     * Allows the vertex shader to manipulate the point size
-     */
-    glEnable(GL_PROGRAM_POINT_SIZE);    // Manipulate point size
+    Settings settings;
+    if (!loadSettings(settings, configPath, overrides)) {
+        return 1;
+    }
+    if (printOnly) {
+        printSettings(std::cout, settings);
+        return 0;
+    }
+    const int windowWidth = settings.width, windowHeight = settings.height;
+    if (posterWidth > 0 && (!headless || outputPath.empty() || !exportPath.empty())) {
+        std::cerr << "--poster renders headless into the --output file, without --export" << std::endl;
+        return 1;
+    }
+    if (!tracePath.empty()) {
+        Trace::start(settings.traceEvents);
+        Trace::setThreadName("main");
+    }
 
     if (argc == 0 || argv[0] == nullptr) {
         std::cerr << "Unable to determine the executable path." << std::endl;
         return 1;
     }
+    // Shaders are found relative to the executable's directory; the build emits the
+    // SPIR-V modules next to it when glslang is installed
+    fs::path execDir = fs::absolute(argv[0]).parent_path();
+    PointSphereConfig& config = settings.sphere;
+    config.shaderDir = execDir / "../src/shaders";
+    config.spirvDir = execDir / "shaders";
+
+    if (cpu) {
+        if (!headless || posterWidth > 0) {
+            std::cerr << "--cpu renders --headless frames, without --poster" << std::endl;
+            return 1;
+        }
+        int status = renderCpu(config, windowWidth, windowHeight, headlessFrames, outputPath, exportPath);
+        if (!tracePath.empty() && !Trace::write(tracePath)) {
+            status = 1;
+        }
+        return status;
+    }
 
-    // Get the executable's directory
-    fs::path execPath = fs::absolute(argv[0]);
-    fs::path execDir = execPath.parent_path();
-
-    // Construct shader paths relative to the executable directory
-    fs::path vertexShaderPath = execDir / "../src/shaders/vertex.glsl";
-    fs::path fragmentShaderPath = execDir / "../src/shaders/fragment.glsl";
-    // Set up the shader
-    Shader shader(vertexShaderPath.string(), fragmentShaderPath.string());
-
-    unsigned int VBO = 0;
-    glGenBuffers(1, &VBO);
-
-    unsigned int VAO = 0;
-    glGenVertexArrays(1, &VAO);
-
-    glBindVertexArray(VAO);
+    // Closes the window system or the headless context on return, after the GL
+    // objects owned by main have been released
+    struct ContextSession {
+        bool glfw = false;
+        #ifdef POINT_SPHERE_EGL
+        HeadlessContext * headless = NULL;
+        #endif
+        ~ContextSession() {
+            #ifdef POINT_SPHERE_EGL
+            if (headless != NULL) {
+                headless->terminate();
+                delete headless;
+            }
+            #endif
+            if (glfw) {
+                glfwTerminate();
+            }
+        }
+    } session;
 
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    GLFWwindow * window = NULL;
+    // What the frames are drawn into: the window's default framebuffer or the headless one
+    unsigned int targetFramebuffer = 0;
+    int framebufferWidth = windowWidth, framebufferHeight = windowHeight;
+    // Poster tiles replace the frames of a headless run, one per loop iteration
+    TileLayout * posterTiles = NULL;
+    TiledImageWriter * posterWriter = NULL;
+    float pointScale = 1.0f;
+
+    if (headless) {
+        #ifdef POINT_SPHERE_EGL
+        session.headless = new HeadlessContext(windowWidth, windowHeight, pointModeNeedsMultisample(config.pointMode) ? 4 : 0);
+        if (!session.headless->valid()) {
+            std::cerr << "Failed to create a headless GL context" << std::endl;
+            return -1;
+        }
+        if (!gladLoadGLLoader((GLADloadproc)HeadlessContext::getProcAddress)) {
+            std::cerr << "Failed to initialize GLAD" << std::endl;
+            return -1;
+        }
+        if (posterWidth > 0) {
+            // Points grow with the poster; the margin around each tile fits half the largest
+            pointScale = (float)std::min(posterWidth, posterHeight) / std::min(windowWidth, windowHeight);
+            float largestPoint = (1.0f + config.pointSizeOffset) / config.pointSizeDivisor * pointScale;
+            if (config.pointMode == POINT_MODE_ANALYTIC) {
+                largestPoint += ANALYTIC_SPRITE_MARGIN;
+            }
+            if (largestPoint > TileLayout::maxPointSize()) {
+                std::cerr << "Points above " << TileLayout::maxPointSize() << " pixels are clamped by this context" << std::endl;
+                largestPoint = TileLayout::maxPointSize();
+            }
+            int margin = (int)ceil(largestPoint / 2.0f) + 1;
+            posterTiles = new TileLayout(posterWidth, posterHeight, TileLayout::maxTileSize(settings.posterTileSize, margin), margin);
+            posterWriter = new TiledImageWriter(outputPath, posterWidth, posterHeight);
+            if (!posterWriter->valid()) {
+                delete posterWriter;
+                delete posterTiles;
+                return 1;
+            }
+            framebufferWidth = framebufferHeight = posterTiles->framebufferSize();
+            session.headless->createFramebuffer(framebufferWidth, framebufferHeight);
+            std::cerr << "Rendering " << posterWidth << "x" << posterHeight << " in " << posterTiles->count()
+                      << " tiles of " << posterTiles->tileSize << " pixels" << std::endl;
+        } else {
+            session.headless->createFramebuffer();
+        }
+        targetFramebuffer = session.headless->framebuffer();
+        #else
+        std::cerr << "Headless rendering needs a build with EGL" << std::endl;
+        return 1;
+        #endif
+    } else {
+        if (!glfwInit()) {
+            std::cerr << "Issue with inializing glfw" << std::endl;
+            return -1;
+        }
+        session.glfw = true;
+
+        // Setup OpenGL version (using 3.3)
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+        if (pointModeNeedsMultisample(config.pointMode)) {
+            glfwWindowHint(GLFW_SAMPLES, 4);
+        }
+
+        window = glfwCreateWindow(windowWidth, windowHeight, "point-sphere", NULL, NULL);
+        if (window == NULL) {
+            std::cerr << "Failed to create GLFW window" << std::endl;
+            return -1;
+        }
+        glfwMakeContextCurrent(window);
+
+        if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+            std::cerr << "Failed to initialize GLAD" << std::endl;
+            return -1;
+        }
+        glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+    }
 
-    // Pass data to VBO
-    glBufferData(GL_ARRAY_BUFFER, 3 * sizeof(float) * NUM_POINTS, points3D, GL_STATIC_DRAW);
+    // Frame export at the initial framebuffer size: frames come back through a ring of pixel
+    // buffers and are encoded on another thread, so neither stalls the render loop
+    FrameEncoder * encoder = NULL;
+    FrameReadback * readback = NULL;
+    FrameReadback::Sink exportFrame = [&encoder](const unsigned char* rgba) { encoder->submit(rgba); };
+    if (!exportPath.empty()) {
+        encoder = new FrameEncoder(exportPath, framebufferWidth, framebufferHeight);
+        if (!encoder->valid()) {
+            delete encoder;
+            return 1;
+        }
+        readback = new FrameReadback(framebufferWidth, framebufferHeight);
+    }
 
-    // Tell the VAO how to interpret the data
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), NULL);
-    glEnableVertexAttribArray(0);
-    
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(VAO);
+    // The sphere's programs and buffers are released before the context
+    config.pointScale = pointScale;
+    std::unique_ptr<PointSphere> sphere(new PointSphere(config));
 
     // Default value of the direction vector
     glm::vec3 directionVector = glm::normalize(glm::vec3(-2, 3, 1));
-    
-    // Main loop
-    while (!glfwWindowShouldClose(window)) {
-        // Process input
-        process_input(window);
-
-        #if MOUSE_TRACKING
-
-        // Get mouse position and window position to make the sphere rotate in the direction
-        // of the user's mouse
-        double mouseX, mouseY;
-        glfwGetCursorPos(window, &mouseX, &mouseY);
 
-        int width, height;
-        glfwGetWindowSize(window, &width, &height);
+    #ifdef SIGUSR1
+    PROFILE_REPORT_ON_SIGNAL(SIGUSR1);
+    #endif
+
+    // Window frames wait until the sphere has moved enough to show; events wake the loop.
+    // An export plays back at a fixed rate, so then every frame is drawn at that rate
+    auto windowPacer = [&encoder](const Settings& current) {
+        if (encoder != NULL) {
+            return FramePacer(encoder->framesPerSecond(), 0.0);
+        }
+        return FramePacer(current.targetFps, current.pacingPixels);
+    };
+    WindowInput windowInput(windowPacer(settings), settings.mouseTracking);
+    FramePacer& pacer = windowInput.pacer;
+    // When the frames being drawn will be shown, for taking the drag late and predicting it
+    DisplayClock display(60.0);
+    double latchedAt = 0.0;
+    if (!headless) {
+        glfwSetWindowUserPointer(window, &windowInput);
+        glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+        glfwSetWindowRefreshCallback(window, invalidate_callback);
+        glfwSetKeyCallback(window, key_callback);
+        glfwSetCursorPosCallback(window, cursor_position_callback);
+        glfwSetMouseButtonCallback(window, mouse_button_callback);
+        const GLFWvidmode* mode = glfwGetVideoMode(glfwGetPrimaryMonitor());
+        if (mode != NULL && mode->refreshRate > 0) {
+            display.refreshInterval = 1.0 / mode->refreshRate;
+        }
+    }
 
-        double relX = -1.0f * (float) width / 2.0f + mouseX;
-        double relY = (float) height / 2.0f - mouseY;
+    // In a window the main thread handles events and input and publishes each frame's
+    // state; the render thread draws the latest one, so a slow frame never holds up input
+    TripleBuffer<FrameInput> windowStates;
+    std::mutex renderWakeMutex;
+    std::condition_variable renderWake;
+    bool renderQuit = false;
+    // Settings reloaded on the main thread; the render thread applies them between frames,
+    // or leaves run() to build a new sphere when they need one
+    bool reloadPending = false;
+    PointSphereConfig reloadConfig;
+    bool rebuildSphere = false;
 
-        directionVector = glm::normalize(glm::vec3(relX, relY, 5.0f));
+    // Main loop
+    const int frames = posterTiles != NULL ? posterTiles->count() : headlessFrames;
+    bool posterFailed = false;
+    std::vector<unsigned char> tilePixels;
+    FrameHooks hooks;
+    hooks.beginFrame = [&](int frame, FrameInput& input) {
+        if (!headless) {
+            {
+                PROFILE_SCOPE("wait for state");
+                std::unique_lock<std::mutex> lock(renderWakeMutex);
+                do {
+                    renderWake.wait(lock, [&] { return windowStates.fresh() || reloadPending || renderQuit; });
+                    if (renderQuit) {
+                        return false;
+                    }
+                    if (reloadPending) {
+                        reloadPending = false;
+                        if (!sphere->reconfigure(reloadConfig)) {
+                            rebuildSphere = true;
+                            return false;
+                        }
+                    }
+                } while (!windowStates.fresh());
+            }
+            windowStates.update();
+            input = windowStates.front();
+            latchedAt = glfwGetTime();
+
+            // While the sphere is dragged, wait until the latest moment that still makes the
+            // next vsync, then take the newest drag and predict it, and the time, to that vsync
+            windowInput.arcballSamples.update();
+            double vsync = display.nextVsync(glfwGetTime());
+            if (windowInput.arcballSamples.front().moving(glfwGetTime())) {
+                PROFILE_SCOPE("late latch");
+                double wait = display.latchTime(vsync) - glfwGetTime();
+                if (wait > 0.0) {
+                    std::this_thread::sleep_for(std::chrono::duration<double>(wait));
+                }
+                windowInput.arcballSamples.update();
+                latchedAt = glfwGetTime();
+            }
+            input.time = (float)vsync;
+            input.orientation = windowInput.arcballSamples.front().predict(vsync);
+            return true;
+        }
+        if (frame >= frames) {
+            return false;
+        }
+
+        // Headless frames are 1/60 s apart, so the same arguments render the same images;
+        // every poster tile shows the last of --frames
+        input.time = posterTiles != NULL ? (headlessFrames - 1) / 60.0f : frame / 60.0f;
+        input.axis = directionVector;
+        if (posterTiles != NULL) {
+            input.projection = posterTiles->projection(posterTiles->tile(frame));
+        }
+        input.framebufferWidth = framebufferWidth;
+        input.framebufferHeight = framebufferHeight;
+        input.framebuffer = targetFramebuffer;
+        return true;
+    };
+    hooks.endFrame = [&](int frame) {
+        if (readback != NULL) {
+            PROFILE_SCOPE("readback");
+            unsigned int source = targetFramebuffer;
+            #ifdef POINT_SPHERE_EGL
+            if (session.headless != NULL) {
+                source = session.headless->readableFramebuffer();
+            }
+            #endif
+            readback->capture(source, exportFrame);
+        }
+
+        #ifdef POINT_SPHERE_EGL
+        if (posterTiles != NULL) {
+            // Only the tile inside the margin is kept
+            PROFILE_SCOPE("tile readback");
+            Tile tile = posterTiles->tile(frame);
+            tilePixels.resize((size_t)tile.width * tile.height * 3);
+            session.headless->readPixels(posterTiles->margin, posterTiles->margin, tile.width, tile.height, tilePixels.data());
+            if (!posterWriter->write(tile, tilePixels.data())) {
+                posterFailed = true;
+                return false;
+            }
+        }
         #endif
 
-        // std::cout << "Direction vector: " << glm::to_string(directionVector) << std::endl;
-
-        // Render
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-        // Alter the radians value to increase or decrease the speed of rotation
-        glm::mat4 rotation = glm::rotate(
-            glm::mat4(1.0f),
-            (float)glfwGetTime() * 0.07f,
-            glm::normalize(directionVector)    // A random unit vector (could set this to my mouse position)
-        );
-
-        // Passing the rotation matrix to the shader
-        shader.use();
-        shader.setMat4("rotation", glm::value_ptr(rotation));
-
-        glBindVertexArray(VAO);
-        glDrawArrays(GL_POINTS, 0, NUM_POINTS);
-
-        // Check and call events and swap the buffers
-        glfwPollEvents();
-        glfwSwapBuffers(window);
+        // Swap the buffers and wake the main thread for the next state
+        if (!headless) {
+            PROFILE_SCOPE("swap");
+            double swapStart = glfwGetTime();
+            glfwSwapBuffers(window);
+            display.swapped(glfwGetTime(), swapStart - latchedAt);
+            glfwPostEmptyEvent();
+        }
+        return true;
+    };
+
+    int frame = 0;
+    if (headless) {
+        frame = sphere->run(hooks);
+    } else {
+        // The context belongs to the render thread until it is done
+        glfwMakeContextCurrent(NULL);
+        std::thread renderThread([&] {
+            glfwMakeContextCurrent(window);
+            // Swaps return at a vsync, which the DisplayClock's latch and prediction rely on
+            glfwSwapInterval(1);
+            Trace::setThreadName("render");
+            for (;;) {
+                sphere->run(hooks);
+                if (!rebuildSphere) {
+                    break;
+                }
+                // the old sphere's programs and buffers go before the new one's are made
+                rebuildSphere = false;
+                PointSphereConfig rebuildConfig;
+                {
+                    std::lock_guard<std::mutex> lock(renderWakeMutex);
+                    rebuildConfig = reloadConfig;
+                }
+                sphere.reset();
+                sphere.reset(new PointSphere(rebuildConfig));
+            }
+            glfwMakeContextCurrent(NULL);
+        });
+
+        double nextSettingsPoll = glfwGetTime() + SETTINGS_POLL_INTERVAL;
+        fs::file_time_type settingsWritten;
+        std::error_code settingsError;
+        if (!configPath.empty()) {
+            settingsWritten = fs::last_write_time(configPath, settingsError);
+        }
+
+        while (!glfwWindowShouldClose(window)) {
+            // Process input
+            {
+                TRACE_SCOPE("input");
+                process_input(window);
+            }
+
+            // The prediction runs on for a moment after the last cursor event
+            if (windowInput.arcball.sample().moving(glfwGetTime())) {
+                pacer.invalidate();
+            }
+
+            // Apply an edited settings file: the pacing and mouse here, the sphere's on the
+            // render thread before its next frame
+            if (!configPath.empty() && glfwGetTime() >= nextSettingsPoll) {
+                nextSettingsPoll = glfwGetTime() + SETTINGS_POLL_INTERVAL;
+                fs::file_time_type written = fs::last_write_time(configPath, settingsError);
+                if (!settingsError && written != settingsWritten) {
+                    settingsWritten = written;
+                    if (reloadSettings(settings, configPath, overrides)) {
+                        FramePacer reloaded = windowPacer(settings);
+                        pacer.targetFps = reloaded.targetFps;
+                        pacer.pixelThreshold = reloaded.pixelThreshold;
+                        windowInput.mouseTracking = settings.mouseTracking;
+                        {
+                            std::lock_guard<std::mutex> lock(renderWakeMutex);
+                            reloadPending = true;
+                            reloadConfig = settings.sphere;
+                        }
+                        renderWake.notify_one();
+                        pacer.invalidate();
+                    }
+                }
+            }
+
+            // Publish a frame once the pacer finds it worth drawing; the newest state replaces
+            // one the render thread has not picked up yet
+            glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+            float pixelsPerSecond = config.pixelsPerSecond(std::min(framebufferWidth, framebufferHeight));
+            double now = glfwGetTime();
+            if (pacer.delay(now, pixelsPerSecond) <= 0.0) {
+                FrameInput& state = windowStates.back();
+                state = FrameInput();
+                state.time = (float)now;
+                state.axis = directionVector;
+                state.framebufferWidth = framebufferWidth;
+                state.framebufferHeight = framebufferHeight;
+                windowStates.publish();
+                // taking the mutex orders the publication before the render thread's check
+                { std::lock_guard<std::mutex> lock(renderWakeMutex); }
+                renderWake.notify_one();
+                pacer.frameDrawn(now);
+            }
+
+            // Sleep until an event, the render thread finishing a frame or the next paced frame
+            double delay = pacer.delay(glfwGetTime(), pixelsPerSecond);
+            if (delay > 0.0) {
+                glfwWaitEventsTimeout(delay);
+            } else {
+                glfwWaitEvents();
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(renderWakeMutex);
+            renderQuit = true;
+        }
+        renderWake.notify_one();
+        renderThread.join();
+        glfwMakeContextCurrent(window);
     }
 
-    // Clean up
-    glDeleteVertexArrays(1, &VAO);
-    glDeleteBuffers(1, &VBO);
-    shader.terminate();
-    glfwTerminate();
-    return 0;
+    int status = 0;
+    if (readback != NULL) {
+        readback->flush(exportFrame);
+        delete readback;
+        encoder->finish();
+        std::cerr << "Exported " << encoder->framesWritten() << " frames to " << exportPath << std::endl;
+        delete encoder;
+    }
+    if (posterTiles != NULL) {
+        if (posterFailed || frame < frames || !posterWriter->finish()) {
+            status = 1;
+        }
+        delete posterWriter;
+        delete posterTiles;
+    }
+    #ifdef POINT_SPHERE_EGL
+    else if (headless && !outputPath.empty() && !session.headless->writePPM(outputPath)) {
+        status = 1;
+    }
+    #endif
+
+    PROFILE_REPORT();
+    PROFILE_TERMINATE();
+    if (!tracePath.empty()) {
+        // The last frames' GPU scopes are still in flight
+        glFinish();
+        Trace::collectGpu();
+        if (!Trace::write(tracePath)) {
+            status = 1;
+        }
+        Trace::terminate();
+    }
+    return status;
 } /* main() */
@@ -0,0 +1,353 @@
+#include <point_sphere.h>
+
+#include <iostream>
+
+#include <glad.h>
+
+#include <depth_sort.h>
+#include <frame_constants.h>
+#include <gl_resources.h>
+#include <gl_state.h>
+#include <gpu_culling.h>
+#include <gpu_sort.h>
+#include <hemisphere_culling.h>
+#include <instanced_renderer.h>
+#include <profiler.h>
+#include <rotation_state.h>
+#include <shader.h>
+#include <stream_buffer.h>
+
+std::vector<ShaderConstant> PointSphereConfig::shaderConstants() const
+{
+    return {
+        {0, "POINT_SIZE_OFFSET", pointSizeOffset},      // Map z: [-1, 1] to PointSize: [0, ]
+        {1, "POINT_SIZE_DIVISOR", pointSizeDivisor},
+        {2, "DEPTH_THRESHOLD", depthThreshold},         // Points farther than this are drawn in backColor
+        {3, "BACK_CULL_Z", opaqueLook ? 0.0f : -2.0f},  // Rotated z below this is culled
+        {4, "POINT_MODE", (float)pointMode},
+    };
+}
+
+float PointSphereConfig::pixelsPerSecond(int viewportSize) const
+{
+    // A point on the sphere moves at radius * angular speed; the ripple's three waves
+    // (displacePoints()) add at most amplitude * radius * the sum of their frequencies
+    float speed = rotationSpeed * scale;
+    if (animated)
+        speed += animationAmplitude * scale * (2.1f + 1.3f + 0.7f);
+    // Grid spheres also turn about their own axes; InstancedRenderer::grid() makes
+    // them 1 / columns the size of the single sphere
+    if (numSpheres > 1)
+        speed += std::fabs(sphereSpin) * scale / std::ceil(std::sqrt((float)numSpheres));
+    return speed * viewportSize / 2.0f;
+}
+
+struct PointSphere::Impl
+{
+    PointSphereConfig config;
+    std::vector<vec3local> points;
+
+    // Groups the points into patches so the far ones can be skipped as a whole
+    HemisphereCuller* hemisphereCuller = NULL;
+    std::vector<GLint> visibleFirsts;
+    std::vector<GLsizei> visibleCounts;
+
+    Program shader;
+    Program* instancedShader = NULL;
+    InstancedRenderer* spheres = NULL;
+    CulledRenderer* culledSpheres = NULL;
+    // The grid spheres' own turning, when sphereSpin is set
+    RotationBatch sphereRotations;
+
+    // The sphere's rotation, advanced by the time since the last frame
+    RotationState rotation;
+
+    // Per-frame constants shared by every program
+    FrameConstantsBuffer frameConstantsBuffer;
+    FrameConstants frameConstants;
+
+    // Translucent points composited without sorting
+    WeightedBlendedOIT* weightedOIT = NULL;
+    LinkedListOIT* linkedListOIT = NULL;
+
+    Buffer pointBuffer;
+    VertexArray vertexArray;
+    // Displaced positions; the CPU writes one region while the GPU draws from another
+    StreamBuffer* pointStream = NULL;
+    // Point indices in back-to-front order, rewritten every frame
+    Buffer indexBuffer;
+    std::vector<uint32_t> sortedIndices;
+    GpuDepthSorter* gpuSorter = NULL;
+
+    Impl(const PointSphereConfig& config)
+        : config(config), points(generate(config)), shader(build(config)), frameConstantsBuffer(config.bufferStrategy)
+    {
+    }
+
+    ~Impl()
+    {
+        // The culled renderer draws from the spheres' buffers, so it goes first
+        delete pointStream;
+        delete gpuSorter;
+        delete culledSpheres;
+        delete spheres;
+        delete instancedShader;
+        delete weightedOIT;
+        delete linkedListOIT;
+        delete hemisphereCuller;
+    }
+
+    static std::vector<vec3local> generate(const PointSphereConfig& config)
+    {
+        std::vector<vec3local> points(config.numPoints);
+        if (config.generator == POINT_GENERATOR_RANDOM)
+            populate3Drand(points.data(), config.numPoints, config.scale, config.seed);
+        else
+            populate3Darray(points.data(), config.numPoints, config.scale);
+        return points;
+    }
+
+    // Prefers the precompiled SPIR-V and falls back to the GLSL sources
+    static Shader build(const PointSphereConfig& config)
+    {
+        return Shader::fromSpirv((config.spirvDir / "vertex.spv").string(), (config.spirvDir / "fragment.spv").string(),
+                                 (config.shaderDir / "vertex.glsl").string(), (config.shaderDir / "fragment.glsl").string(),
+                                 config.shaderConstants());
+    }
+};
+
+PointSphere::PointSphere(const PointSphereConfig& config) : impl(new Impl(config))
+{
+    Impl& s = *impl;
+    const int count = config.numPoints;
+    if (config.opaqueLook)
+        s.hemisphereCuller = new HemisphereCuller(s.points.data(), count);
+
+    if (config.numSpheres > 1)
+    {
+        s.instancedShader = new Program(Shader((config.shaderDir / "instanced_vertex.glsl").string(),
+                                               (config.shaderDir / "instanced_fragment.glsl").string(),
+                                               config.shaderConstants()));
+        s.spheres = new InstancedRenderer(s.points.data(), count);
+        std::vector<SphereInstance> instances = InstancedRenderer::grid(config.numSpheres, count);
+        s.spheres->setInstances(instances.data(), (int)instances.size());
+        if (config.sphereSpin != 0.0f)
+            s.sphereRotations = InstancedRenderer::spin(instances, config.sphereSpin);
+        if (CulledRenderer::supported())
+            s.culledSpheres = new CulledRenderer(*s.spheres, Shader::compute((config.shaderDir / "cull_compute.glsl").string()), config.scale);
+    }
+
+    s.frameConstants.pointScale.x = config.pointScale;
+    if (config.transparencyMode != TRANSPARENCY_NONE)
+    {
+        s.frameConstants.backColor.a = config.transparentAlpha;
+        s.frameConstants.frontColor.a = config.transparentAlpha;
+        if (config.transparencyMode == TRANSPARENCY_WEIGHTED && WeightedBlendedOIT::supported())
+            s.weightedOIT = new WeightedBlendedOIT(config.shaderDir, config.shaderConstants());
+        else if (config.transparencyMode == TRANSPARENCY_LINKED_LIST && LinkedListOIT::supported())
+            s.linkedListOIT = new LinkedListOIT(config.shaderDir, config.shaderConstants());
+        else
+            std::cerr << "Order-independent transparency is not supported by this context" << std::endl;
+    }
+
+    // Pass data to the vertex buffer and tell the VAO how to interpret it
+    s.pointBuffer.storage(sizeof(vec3local) * count, s.points.data());
+    s.vertexArray.attribute(0, s.pointBuffer.ID, 3, GL_FLOAT, sizeof(vec3local));
+    if (config.animated)
+    {
+        s.pointStream = new StreamBuffer(sizeof(vec3local) * count, 3, 1, config.bufferStrategy);
+        s.vertexArray.attribute(0, s.pointStream->ID, 3, GL_FLOAT, sizeof(vec3local));
+    }
+
+    if (config.depthSort)
+    {
+        s.vertexArray.elementBuffer(s.indexBuffer.ID);
+        if (config.depthSort == 2 && !config.animated && GpuDepthSorter::supported())
+        {
+            s.gpuSorter = new GpuDepthSorter(config.shaderDir);
+            s.vertexArray.elementBuffer(s.gpuSorter->indexBuffer());
+        }
+    }
+}
+
+PointSphere::~PointSphere() = default;
+
+const PointSphereConfig& PointSphere::config() const
+{
+    return impl->config;
+}
+
+const std::vector<vec3local>& PointSphere::points() const
+{
+    return impl->points;
+}
+
+float PointSphere::pixelsPerSecond(int viewportSize) const
+{
+    return impl->config.pixelsPerSecond(viewportSize);
+}
+
+bool PointSphere::reconfigure(const PointSphereConfig& config)
+{
+    const PointSphereConfig& current = impl->config;
+    bool sameBuild = config.numPoints == current.numPoints && config.scale == current.scale
+        && config.generator == current.generator && config.seed == current.seed
+        && config.pointSizeOffset == current.pointSizeOffset && config.pointSizeDivisor == current.pointSizeDivisor
+        && config.depthThreshold == current.depthThreshold && config.pointScale == current.pointScale
+        && config.opaqueLook == current.opaqueLook && config.pointMode == current.pointMode
+        && config.depthSort == current.depthSort && config.transparencyMode == current.transparencyMode
+        && config.transparentAlpha == current.transparentAlpha && config.animated == current.animated
+        && config.numSpheres == current.numSpheres && config.sphereSpin == current.sphereSpin
+        && config.bufferStrategy == current.bufferStrategy
+        && config.shaderDir == current.shaderDir && config.spirvDir == current.spirvDir;
+    if (!sameBuild)
+        return false;
+    if (config.stateStats && !current.stateStats)
+        GLState::resetCounters();
+    impl->config = config;
+    return true;
+}
+
+void PointSphere::render(const FrameInput& input)
+{
+    Impl& s = *impl;
+    const PointSphereConfig& config = s.config;
+    const int count = config.numPoints;
+
+    // The viewport is the largest centered square of the framebuffer
+    int viewportSize = std::max(1, std::min(input.framebufferWidth, input.framebufferHeight));
+    int viewportX = (input.framebufferWidth - viewportSize) / 2;
+    int viewportY = (input.framebufferHeight - viewportSize) / 2;
+    glBindFramebuffer(GL_FRAMEBUFFER, input.framebuffer);
+    glViewport(viewportX, viewportY, viewportSize, viewportSize);
+    GLState::enable(GL_PROGRAM_POINT_SIZE);     // The vertex shader sets the point size
+
+    if (input.clear)
+    {
+        PROFILE_GPU_SCOPE("clear");
+        GLState::depthMask(GL_TRUE);            // The depth write mask applies to clears too
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    }
+    applyPointMode(config.pointMode);
+
+    FrameConstants& frameConstants = s.frameConstants;
+    const float elapsed = input.time - frameConstants.time.x;
+    s.rotation.angularVelocity = glm::normalize(input.axis) * config.rotationSpeed;
+    s.rotation.integrate(elapsed);
+    frameConstants.rotation = glm::mat4(s.rotation.matrix());
+    if (input.orientation != glm::quat(1.0f, 0.0f, 0.0f, 0.0f))
+        frameConstants.rotation = glm::mat4_cast(input.orientation) * frameConstants.rotation;
+    frameConstants.time = glm::vec4(input.time, elapsed, 0.0f, 0.0f);
+    frameConstants.projection = input.projection;
+    frameConstants.viewport = glm::vec4(viewportSize, viewportSize, 1.0f / viewportSize, 1.0f / viewportSize);
+
+    // Passing the per-frame constants to every shader in one upload
+    {
+        PROFILE_SCOPE("constants");
+        s.frameConstantsBuffer.update(frameConstants);
+    }
+
+    if (s.spheres != NULL)
+    {
+        if (s.sphereRotations.size() > 0)
+        {
+            PROFILE_SCOPE("spin");
+            s.sphereRotations.integrate(elapsed);
+            s.spheres->setOrientations(s.sphereRotations);
+        }
+        PROFILE_GPU_SCOPE("draw");
+        if (s.culledSpheres != NULL)
+            s.culledSpheres->draw(*s.instancedShader);
+        else
+            s.spheres->draw(*s.instancedShader);
+        return;
+    }
+
+    GLint firstPoint = 0;
+    if (s.pointStream != NULL)
+    {
+        displacePoints(s.points.data(), static_cast<vec3local*>(s.pointStream->begin()), count, input.time, config.animationAmplitude);
+        s.pointStream->end();
+        firstPoint = (GLint)(s.pointStream->offset() / sizeof(vec3local));
+    }
+    // Compute passes bind their own programs, so they go before the draw's
+    if (s.gpuSorter != NULL)
+    {
+        PROFILE_GPU_SCOPE("gpu sort");
+        s.gpuSorter->sort(s.pointBuffer.ID, count);
+    }
+
+    PROFILE_GPU_SCOPE("draw");
+    s.shader.use();
+    s.vertexArray.bind();
+
+    // The OIT passes take over the program and target; any draw order works
+    if (s.weightedOIT != NULL)
+        s.weightedOIT->begin(viewportSize, viewportSize);
+    else if (s.linkedListOIT != NULL)
+        s.linkedListOIT->begin(viewportSize, viewportSize, viewportX, viewportY);
+
+    if (config.depthSort)
+    {
+        if (s.gpuSorter == NULL)
+        {
+            PROFILE_SCOPE("cpu sort");
+            depthSortCPU(s.points.data(), count, frameConstants.rotation, s.sortedIndices);
+            s.indexBuffer.data(sizeof(uint32_t) * count, s.sortedIndices.data(), GL_STREAM_DRAW);
+        }
+        glDrawElementsBaseVertex(GL_POINTS, count, GL_UNSIGNED_INT, NULL, firstPoint);
+    }
+    else if (s.hemisphereCuller != NULL)
+    {
+        s.hemisphereCuller->visibleRanges(frameConstants.rotation, 0.0f, s.visibleFirsts, s.visibleCounts);
+        for (GLint& first : s.visibleFirsts)
+            first += firstPoint;
+        glMultiDrawArrays(GL_POINTS, s.visibleFirsts.data(), s.visibleCounts.data(), (GLsizei)s.visibleFirsts.size());
+    }
+    else
+    {
+        glDrawArrays(GL_POINTS, firstPoint, count);
+    }
+
+    if (s.weightedOIT != NULL)
+        s.weightedOIT->end(input.framebuffer, viewportX, viewportY);
+    else if (s.linkedListOIT != NULL)
+        s.linkedListOIT->end(input.framebuffer, viewportX, viewportY);
+}
+
+void PointSphere::invalidateState()
+{
+    GLState::invalidate();
+}
+
+int PointSphere::run(const FrameHooks& hooks)
+{
+    // The caller may have set state before the loop; the hooks go through GLState
+    invalidateState();
+    if (impl->config.stateStats)
+        GLState::resetCounters();
+
+    FrameInput input;
+    int frame = 0;
+    for (;;)
+    {
+        PROFILE_FRAME_BEGIN();
+        if (hooks.beginFrame && !hooks.beginFrame(frame, input))
+            break;
+        render(input);
+        bool more = !hooks.endFrame || hooks.endFrame(frame);
+        frame++;
+        PROFILE_FRAME_END();
+
+        if (impl->config.stateStats && frame % 60 == 0)
+        {
+            const GLStateCounters& counters = GLState::counters();
+            std::cout << "GL state changes per frame: " << counters.issued / 60.0 << " issued, "
+                      << counters.elided / 60.0 << " elided" << std::endl;
+            GLState::resetCounters();
+        }
+        if (!more)
+            break;
+    }
+    return frame;
+}
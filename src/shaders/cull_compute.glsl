@@ -0,0 +1,82 @@
+#version 430 core
+
+// Minimum and maximum points drawn per visible sphere; the instance's own lod caps it further
+#ifndef MIN_LOD_POINTS
+#define MIN_LOD_POINTS 64
+#endif
+// Points drawn per square pixel of the sphere's projected radius
+#ifndef LOD_DENSITY
+#define LOD_DENSITY 0.5
+#endif
+
+layout (local_size_x = 64) in;
+
+// Same layout as struct SphereInstance
+struct SphereInstance {
+    vec4 positionScale;     // xyz = center, w = scale
+    vec4 orientation;
+    vec4 color;
+    float lod;
+};
+
+// Same layout as the GL DrawArraysIndirectCommand
+struct DrawArraysIndirectCommand {
+    uint count;
+    uint instanceCount;
+    uint first;
+    uint baseInstance;
+};
+
+layout (std430, binding = 0) readonly buffer Instances {
+    SphereInstance instances[];
+};
+
+layout (std430, binding = 1) writeonly buffer Commands {
+    DrawArraysIndirectCommand commands[];
+};
+
+#include "frame_constants.glsl"
+
+uniform uint instanceCount;
+uniform float sphereRadius;     // radius of the unit sphere's points
+
+// True if the sphere is at least partly inside the clip volume of projection
+bool insideFrustum(vec3 center, float radius) {
+    // Frustum planes from the rows of the projection matrix (Gribb & Hartmann)
+    mat4 m = transpose(projection);
+    vec4 planes[6] = vec4[6](m[3] + m[0], m[3] - m[0],
+                             m[3] + m[1], m[3] - m[1],
+                             m[3] + m[2], m[3] - m[2]);
+    for (int i = 0; i < 6; i++) {
+        vec4 plane = planes[i] / length(planes[i].xyz);
+        if (dot(plane.xyz, center) + plane.w < -radius) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void main() {
+    uint index = gl_GlobalInvocationID.x;
+    if (index >= instanceCount) {
+        return;
+    }
+
+    SphereInstance instance = instances[index];
+    vec3 center = instance.positionScale.xyz;
+    float radius = sphereRadius * instance.positionScale.w;
+
+    uint count = 0u;
+    if (insideFrustum(center, radius)) {
+        // Projected radius in pixels picks how many of the progressive points to draw
+        vec4 clip = projection * vec4(center, 1.0);
+        float pixelRadius = radius * abs(projection[1][1]) / max(clip.w, 1e-4) * viewport.y * 0.5;
+        float wanted = max(float(MIN_LOD_POINTS), pixelRadius * pixelRadius * LOD_DENSITY);
+        count = uint(min(wanted, instance.lod));
+    }
+
+    commands[index].count = count;
+    commands[index].instanceCount = count > 0u ? 1u : 0u;
+    commands[index].first = 0u;
+    commands[index].baseInstance = index;
+}
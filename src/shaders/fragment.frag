@@ -0,0 +1,26 @@
+#version 450 core
+#extension GL_GOOGLE_include_directive : require
+
+// SPIR-V build of fragment.glsl; compile with glslangValidator -G
+layout (constant_id = 2) const float DEPTH_THRESHOLD = 0.3;
+layout (constant_id = 4) const float POINT_MODE = 0.0;
+
+layout (location = 0) out vec4 FragColor;
+
+#include "frame_constants.glsl"
+
+#include "point_coverage.glsl"
+
+void main(void) {
+
+    float alpha = pointCoverage();
+
+    vec4 color = gl_FragCoord.z < DEPTH_THRESHOLD ? backColor : frontColor;
+    if (POINT_MODE == POINT_MODE_ANALYTIC) {
+        // Premultiplied for glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA)
+        float coverage = color.a * alpha;
+        FragColor = vec4(color.rgb * coverage, coverage);
+    } else {
+        FragColor = vec4(color.rgb, color.a * alpha);
+    }
+}
@@ -1,23 +1,30 @@
 #version 330 core
 
+// Fragments farther than this depth (smaller z, see vertex.glsl) are drawn in backColor
+#ifndef DEPTH_THRESHOLD
+#define DEPTH_THRESHOLD 0.3
+#endif
+// Round-point technique, see enum PointMode in include/point_modes.h
+#ifndef POINT_MODE
+#define POINT_MODE 0.0
+#endif
+
 out vec4 FragColor;
 
-// This is where we need to round out the points.
+#include "frame_constants.glsl"
 
-void main(void) {
+#include "point_coverage.glsl"
 
-    // gl_PointCoord gives a normalized [0, 1] range
-    vec2 coord = gl_PointCoord - vec2(0.5);
-    float distanceFromCenter = length(coord);
+void main(void) {
 
-    // If the fragment is outside the circle, discard it
-    if (distanceFromCenter > 0.5) {
-        discard;
-    }
+    float alpha = pointCoverage();
 
-    if (gl_FragCoord.z < 0.3) {
-        FragColor = vec4(0.0, 0.0, 0.0, 1.0);
+    vec4 color = gl_FragCoord.z < DEPTH_THRESHOLD ? backColor : frontColor;
+    if (POINT_MODE == POINT_MODE_ANALYTIC) {
+        // Premultiplied for glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA)
+        float coverage = color.a * alpha;
+        FragColor = vec4(color.rgb * coverage, coverage);
     } else {
-        FragColor = vec4(1.0, 1.0, 1.0, 1.0);
+        FragColor = vec4(color.rgb, color.a * alpha);
     }
 }
\ No newline at end of file
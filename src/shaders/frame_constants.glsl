@@ -0,0 +1,15 @@
+// Per-frame constants shared by every program; mirrors struct FrameConstants
+// in include/frame_constants.h and is bound to FRAME_CONSTANTS_BINDING.
+#ifdef GL_SPIRV
+layout (std140, binding = 0) uniform FrameConstants {
+#else
+layout (std140) uniform FrameConstants {
+#endif
+    mat4 rotation;
+    mat4 projection;
+    vec4 backColor;     // depth below DEPTH_THRESHOLD; larger z is nearer
+    vec4 frontColor;
+    vec4 viewport;      // x, y = size in pixels; z, w = 1 / size
+    vec4 time;          // x = seconds since start, y = frame delta
+    vec4 pointScale;    // x = factor on gl_PointSize, for tiled renders
+};
@@ -0,0 +1,31 @@
+#version 330 core
+
+// Fragments farther than this depth within their sphere (smaller vDepth) are drawn in backColor
+#ifndef DEPTH_THRESHOLD
+#define DEPTH_THRESHOLD 0.3
+#endif
+
+in vec4 vColor;
+in float vDepth;        // Depth within the sphere, [0, 1]
+
+out vec4 FragColor;
+
+#include "frame_constants.glsl"
+
+void main(void) {
+
+    // gl_PointCoord gives a normalized [0, 1] range
+    vec2 coord = gl_PointCoord - vec2(0.5);
+    float distanceFromCenter = length(coord);
+
+    // If the fragment is outside the circle, discard it
+    if (distanceFromCenter > 0.5) {
+        discard;
+    }
+
+    if (vDepth < DEPTH_THRESHOLD) {
+        FragColor = backColor;
+    } else {
+        FragColor = vColor;
+    }
+}
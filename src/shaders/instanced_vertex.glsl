@@ -0,0 +1,44 @@
+#version 330 core
+
+// Point-size mapping; overridden by the Shader class through #defines
+#ifndef POINT_SIZE_OFFSET
+#define POINT_SIZE_OFFSET 0.5
+#endif
+#ifndef POINT_SIZE_DIVISOR
+#define POINT_SIZE_DIVISOR 0.23
+#endif
+
+// Unit sphere, shared by every instance
+layout (location = 0) in vec3 aPos;
+
+// Per-instance attributes, see struct SphereInstance
+layout (location = 1) in vec4 aPositionScale;   // xyz = center, w = scale
+layout (location = 2) in vec4 aOrientation;     // quaternion
+layout (location = 3) in vec4 aColor;
+layout (location = 4) in float aLod;            // number of points drawn
+
+#include "frame_constants.glsl"
+
+out vec4 vColor;
+out float vDepth;
+
+vec3 rotateByQuaternion(vec4 q, vec3 v) {
+    return v + 2.0 * cross(q.xyz, cross(q.xyz, v) + q.w * v);
+}
+
+void main() {
+    // The unit sphere is stored in progressive order, so any prefix covers the whole sphere
+    if (gl_VertexID >= int(aLod)) {
+        gl_Position = vec4(2.0, 2.0, 2.0, 1.0);     // Outside clip space, never rasterized
+        gl_PointSize = 1.0;
+        return;
+    }
+
+    vec3 local = rotateByQuaternion(aOrientation, (rotation * vec4(aPos, 1.0)).xyz);
+    gl_Position = projection * vec4(aPositionScale.xyz + local * aPositionScale.w, 1.0);
+
+    // Same mapping as vertex.glsl, relative to the sphere and shrunk with it
+    gl_PointSize = max((local.z + POINT_SIZE_OFFSET) / POINT_SIZE_DIVISOR * aPositionScale.w * pointScale.x, 1.0);
+    vDepth = local.z * 0.5 + 0.5;
+    vColor = aColor;
+}
@@ -0,0 +1,24 @@
+#version 330 core
+
+// Weighted blended OIT, composite pass: resolves the accumulation targets over
+// the framebuffer with glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA)
+
+uniform sampler2D accumulationTexture;
+uniform sampler2D revealageTexture;
+
+// Window position of the viewport; the targets only cover the viewport
+uniform ivec2 viewportOrigin;
+
+out vec4 FragColor;
+
+void main(void) {
+    ivec2 pixel = ivec2(gl_FragCoord.xy) - viewportOrigin;
+    float revealage = texelFetch(revealageTexture, pixel, 0).r;
+    if (revealage >= 1.0) {
+        discard;    // Nothing translucent covered this pixel
+    }
+
+    vec4 accumulation = texelFetch(accumulationTexture, pixel, 0);
+    vec3 average = accumulation.rgb / clamp(accumulation.a, 1e-4, 5e4);
+    FragColor = vec4(average, 1.0 - revealage);
+}
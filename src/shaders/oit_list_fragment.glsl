@@ -0,0 +1,53 @@
+#version 430 core
+
+// Per-pixel linked list OIT, build pass: appends every fragment to its pixel's
+// list in a fixed-size node pool. Fragments beyond the pool are dropped.
+
+#ifndef DEPTH_THRESHOLD
+#define DEPTH_THRESHOLD 0.3
+#endif
+#ifndef POINT_MODE
+#define POINT_MODE 4.0
+#endif
+
+#include "frame_constants.glsl"
+
+#include "point_coverage.glsl"
+
+struct Node {
+    uint color;         // packUnorm4x8, premultiplied
+    float depth;
+    uint next;
+    uint padding;
+};
+
+layout (binding = 0, r32ui) uniform coherent uimage2D heads;
+
+layout (std430, binding = 0) buffer NodeCounter {
+    uint nodeCount;
+};
+
+layout (std430, binding = 1) writeonly buffer Nodes {
+    Node nodes[];
+};
+
+uniform uint nodeCapacity;
+// Window position of the viewport; the heads only cover the viewport
+uniform ivec2 viewportOrigin;
+
+void main(void) {
+    vec4 color = gl_FragCoord.z < DEPTH_THRESHOLD ? backColor : frontColor;
+    float alpha = color.a * pointCoverage();
+    if (alpha <= 0.0) {
+        return;
+    }
+
+    uint index = atomicAdd(nodeCount, 1u);
+    if (index >= nodeCapacity) {
+        return;     // Pool exhausted; memory stays bounded
+    }
+
+    nodes[index].color = packUnorm4x8(vec4(color.rgb * alpha, alpha));
+    nodes[index].depth = gl_FragCoord.z;
+    nodes[index].next = imageAtomicExchange(heads, ivec2(gl_FragCoord.xy) - viewportOrigin, index);
+}
@@ -0,0 +1,70 @@
+#version 430 core
+
+// Per-pixel linked list OIT, resolve pass: sorts the pixel's fragments and blends
+// them back to front, then empties the list for the next frame. The result is
+// drawn with glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA).
+
+// Longest list that is sorted; further fragments of a pixel are ignored
+#ifndef MAX_FRAGMENTS
+#define MAX_FRAGMENTS 16
+#endif
+
+const uint END_OF_LIST = 0xFFFFFFFFu;
+
+struct Node {
+    uint color;
+    float depth;
+    uint next;
+    uint padding;
+};
+
+layout (binding = 0, r32ui) uniform coherent uimage2D heads;
+
+layout (std430, binding = 1) readonly buffer Nodes {
+    Node nodes[];
+};
+
+// Window position of the viewport; the targets only cover the viewport
+uniform ivec2 viewportOrigin;
+
+out vec4 FragColor;
+
+void main(void) {
+    ivec2 pixel = ivec2(gl_FragCoord.xy) - viewportOrigin;
+    uint index = imageAtomicExchange(heads, pixel, END_OF_LIST);
+    if (index == END_OF_LIST) {
+        discard;
+    }
+
+    uint colors[MAX_FRAGMENTS];
+    float depths[MAX_FRAGMENTS];
+    int count = 0;
+    while (index != END_OF_LIST && count < MAX_FRAGMENTS) {
+        colors[count] = nodes[index].color;
+        depths[count] = nodes[index].depth;
+        index = nodes[index].next;
+        count++;
+    }
+
+    // Insertion sort by increasing depth: farthest first, as larger z is nearer here
+    for (int i = 1; i < count; i++) {
+        uint color = colors[i];
+        float depth = depths[i];
+        int j = i - 1;
+        while (j >= 0 && depths[j] > depth) {
+            colors[j + 1] = colors[j];
+            depths[j + 1] = depths[j];
+            j--;
+        }
+        colors[j + 1] = color;
+        depths[j + 1] = depth;
+    }
+
+    // Premultiplied "over", back to front
+    vec4 result = vec4(0.0);
+    for (int i = 0; i < count; i++) {
+        vec4 color = unpackUnorm4x8(colors[i]);
+        result = color + result * (1.0 - color.a);
+    }
+    FragColor = result;
+}
@@ -0,0 +1,31 @@
+#version 330 core
+
+// Weighted blended order-independent transparency, accumulation pass
+// (McGuire & Bavoil 2013). Blend state is set by WeightedBlendedOIT.
+
+#ifndef DEPTH_THRESHOLD
+#define DEPTH_THRESHOLD 0.3
+#endif
+#ifndef POINT_MODE
+#define POINT_MODE 4.0
+#endif
+
+layout (location = 0) out vec4 accumulation;    // sum of premultiplied color * weight
+layout (location = 1) out float revealage;      // product of (1 - alpha)
+
+#include "frame_constants.glsl"
+
+#include "point_coverage.glsl"
+
+void main(void) {
+    vec4 color = gl_FragCoord.z < DEPTH_THRESHOLD ? backColor : frontColor;
+    float alpha = color.a * pointCoverage();
+
+    // Larger z is nearer in this renderer (see the point-size mapping in
+    // vertex.glsl), so weight by closeness to the far end of the depth range
+    float distance = 1.0 - gl_FragCoord.z;
+    float weight = clamp(0.03 / (1e-5 + pow(distance, 4.0)), 1e-2, 3e3);
+
+    accumulation = vec4(color.rgb * alpha, alpha) * weight;
+    revealage = alpha;
+}
@@ -0,0 +1,42 @@
+// Round-point coverage shared by the point fragment shaders. POINT_MODE must be
+// defined before this file is included.
+
+#include "point_sprite.glsl"
+
+// Fraction of the fragment covered by the round point; may discard the fragment
+float pointCoverage() {
+
+    // gl_PointCoord gives a normalized [0, 1] range
+    vec2 coord = gl_PointCoord - vec2(0.5);
+    float alpha = 1.0;
+
+    // POINT_MODE is constant, so only one branch survives compilation
+    if (POINT_MODE == POINT_MODE_DISCARD) {
+        // If the fragment is outside the circle, discard it
+        float distanceFromCenter = length(coord);
+        if (distanceFromCenter > 0.5) {
+            discard;
+        }
+    } else if (POINT_MODE == POINT_MODE_SQUARED_DISTANCE) {
+        // Same circle without the sqrt: |coord|^2 > 0.5^2
+        if (dot(coord, coord) > 0.25) {
+            discard;
+        }
+    } else if (POINT_MODE == POINT_MODE_ALPHA_TO_COVERAGE) {
+        // Fraction of the pixel inside the circle; MSAA turns it into a sample mask
+        float distanceSquared = dot(coord, coord);
+        float edge = max(fwidth(distanceSquared), 1e-5);
+        alpha = clamp((0.25 - distanceSquared) / edge + 0.5, 0.0, 1.0);
+    } else if (POINT_MODE == POINT_MODE_ANALYTIC) {
+        // The sprite is ANALYTIC_SPRITE_MARGIN pixels wider than the circle, see pointSpriteSize()
+        float spriteSize = 1.0 / abs(dFdx(gl_PointCoord.x));
+        coord *= spriteSize / (spriteSize - ANALYTIC_SPRITE_MARGIN);
+        // Coverage of the pixel by the circle's edge, about one pixel wide in screen space
+        float distanceFromCenter = length(coord);
+        float edge = max(fwidth(distanceFromCenter), 1e-5);
+        alpha = clamp((0.5 - distanceFromCenter) / edge + 0.5, 0.0, 1.0);
+    }
+    // POINT_MODE_SQUARE: every fragment of the sprite is kept
+
+    return alpha;
+}
@@ -0,0 +1,22 @@
+// Point sprite size shared by the point vertex shaders and point_coverage.glsl.
+// POINT_MODE must be defined before this file is included.
+
+// POINT_MODE values, see enum PointMode in include/point_modes.h
+const float POINT_MODE_DISCARD = 0.0;
+const float POINT_MODE_SQUARED_DISTANCE = 1.0;
+const float POINT_MODE_ALPHA_TO_COVERAGE = 2.0;
+const float POINT_MODE_SQUARE = 3.0;
+const float POINT_MODE_ANALYTIC = 4.0;
+
+// Pixels the analytic mode's sprite is wider than its circle, so the antialiased
+// edge, which reaches half a pixel past the circle, stays inside the sprite;
+// mirrors ANALYTIC_SPRITE_MARGIN in include/point_modes.h
+const float ANALYTIC_SPRITE_MARGIN = 2.0;
+
+// gl_PointSize for a round point of the given diameter in pixels
+float pointSpriteSize(float diameter) {
+    if (POINT_MODE == POINT_MODE_ANALYTIC) {
+        return max(diameter, 1.0) + ANALYTIC_SPRITE_MARGIN;
+    }
+    return diameter;
+}
@@ -0,0 +1,14 @@
+// Sizes shared by the radix sort compute shaders; mirror the constants in
+// include/gpu_sort.h.
+
+const uint RADIX_BITS = 4u;
+const uint RADIX_SIZE = 16u;            // digits per pass
+const uint THREADS = 256u;              // local_size_x of the block kernels
+const uint ITEMS_PER_THREAD = 4u;
+const uint BLOCK_SIZE = 1024u;          // THREADS * ITEMS_PER_THREAD
+
+// Large sorts dispatch their workgroups in rows (GpuDepthSorter::dispatch()), as
+// only 65535 are guaranteed along x; this numbers them in dispatch order
+uint workGroupIndex() {
+    return gl_WorkGroupID.y * gl_NumWorkGroups.x + gl_WorkGroupID.x;
+}
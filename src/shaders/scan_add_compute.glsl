@@ -0,0 +1,32 @@
+#version 430 core
+
+// Second half of a multi-block scan: adds the scanned total of all earlier blocks
+// to every element of a block (see scan_compute.glsl).
+
+layout (local_size_x = 256) in;
+
+#include "radix_sort.glsl"
+
+layout (std430, binding = 0) buffer Data {
+    uint data[];
+};
+
+layout (std430, binding = 1) readonly buffer BlockSums {
+    uint blockSums[];
+};
+
+uniform uint count;
+
+void main() {
+    uint block = workGroupIndex();
+    if (block * BLOCK_SIZE >= count) {
+        return;     // past the last row's blocks
+    }
+    uint add = blockSums[block];
+    for (uint item = 0u; item < ITEMS_PER_THREAD; item++) {
+        uint index = block * BLOCK_SIZE + item * THREADS + gl_LocalInvocationID.x;
+        if (index < count) {
+            data[index] += add;
+        }
+    }
+}
@@ -0,0 +1,57 @@
+#version 430 core
+
+// Exclusive prefix sum of each BLOCK_SIZE block of data, in place. The total of
+// every block goes to blockSums; scanning those and adding them back with
+// scan_add_compute.glsl completes the scan of the whole array.
+
+layout (local_size_x = 256) in;
+
+#include "radix_sort.glsl"
+
+layout (std430, binding = 0) buffer Data {
+    uint data[];
+};
+
+layout (std430, binding = 1) writeonly buffer BlockSums {
+    uint blockSums[];
+};
+
+uniform uint count;
+
+shared uint partialSums[THREADS];
+
+void main() {
+    uint thread = gl_LocalInvocationID.x;
+    uint block = workGroupIndex();
+    if (block * BLOCK_SIZE >= count) {
+        return;     // past the last row's blocks
+    }
+    uint first = block * BLOCK_SIZE + thread * ITEMS_PER_THREAD;
+
+    uint items[ITEMS_PER_THREAD];
+    uint sum = 0u;
+    for (uint item = 0u; item < ITEMS_PER_THREAD; item++) {
+        items[item] = first + item < count ? data[first + item] : 0u;
+        sum += items[item];
+    }
+
+    partialSums[thread] = sum;
+    barrier();
+    for (uint offset = 1u; offset < THREADS; offset <<= 1u) {
+        uint previous = thread >= offset ? partialSums[thread - offset] : 0u;
+        barrier();
+        partialSums[thread] += previous;
+        barrier();
+    }
+
+    uint running = partialSums[thread] - sum;
+    for (uint item = 0u; item < ITEMS_PER_THREAD; item++) {
+        if (first + item < count) {
+            data[first + item] = running;
+        }
+        running += items[item];
+    }
+    if (thread == THREADS - 1u) {
+        blockSums[block] = partialSums[thread];
+    }
+}
@@ -0,0 +1,48 @@
+#version 430 core
+
+// Radix sort, per pass: how many keys of each block have each digit. The counts
+// are stored digit-major, so an exclusive scan of them gives every block's
+// output offset for every digit.
+
+layout (local_size_x = 256) in;
+
+#include "radix_sort.glsl"
+
+layout (std430, binding = 1) readonly buffer Keys {
+    uint keys[];
+};
+
+layout (std430, binding = 3) writeonly buffer BlockCounts {
+    uint blockCounts[];     // [digit * numBlocks + block]
+};
+
+uniform uint count;
+uniform uint shift;
+uniform uint numBlocks;
+
+shared uint histogram[RADIX_SIZE];
+
+void main() {
+    uint thread = gl_LocalInvocationID.x;
+    uint block = workGroupIndex();
+    if (block >= numBlocks) {
+        return;     // past the last row's blocks
+    }
+
+    if (thread < RADIX_SIZE) {
+        histogram[thread] = 0u;
+    }
+    barrier();
+
+    for (uint item = 0u; item < ITEMS_PER_THREAD; item++) {
+        uint index = block * BLOCK_SIZE + item * THREADS + thread;
+        if (index < count) {
+            atomicAdd(histogram[(keys[index] >> shift) & (RADIX_SIZE - 1u)], 1u);
+        }
+    }
+    barrier();
+
+    if (thread < RADIX_SIZE) {
+        blockCounts[thread * numBlocks + block] = histogram[thread];
+    }
+}
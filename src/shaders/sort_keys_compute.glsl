@@ -0,0 +1,45 @@
+#version 430 core
+
+// Depth sort, first pass: the sort key of every point and its starting index.
+// Matches depthSortCPU() in include/depth_sort.h bit for bit.
+
+layout (local_size_x = 256) in;
+
+layout (std430, binding = 0) readonly buffer Positions {
+    float positions[];      // tightly packed xyz, the vertex buffer itself
+};
+
+layout (std430, binding = 1) writeonly buffer Keys {
+    uint keys[];
+};
+
+layout (std430, binding = 2) writeonly buffer Values {
+    uint values[];
+};
+
+#include "frame_constants.glsl"
+
+#include "radix_sort.glsl"
+
+uniform uint count;
+
+// Unsigned order of the result matches the float order, see sortableFloatKey()
+uint sortableFloatKey(float value) {
+    uint bits = floatBitsToUint(value);
+    return (bits & 0x80000000u) != 0u ? ~bits : (bits | 0x80000000u);
+}
+
+void main() {
+    uint index = workGroupIndex() * THREADS + gl_LocalInvocationID.x;
+    if (index >= count) {
+        return;
+    }
+
+    // Rotated z, evaluated in the CPU reference's order; precise forbids fused multiply-adds
+    vec4 row = vec4(rotation[0][2], rotation[1][2], rotation[2][2], rotation[3][2]);
+    uint base = index * 3u;
+    precise float z = row.x * positions[base] + row.y * positions[base + 1u] + row.z * positions[base + 2u] + row.w;
+
+    keys[index] = sortableFloatKey(z);
+    values[index] = index;
+}
@@ -0,0 +1,107 @@
+#version 430 core
+
+// Radix sort, per pass: moves every key and value to its block's offset for its
+// digit plus its rank among the block's earlier keys with that digit, which keeps
+// the sort stable.
+
+layout (local_size_x = 256) in;
+
+#include "radix_sort.glsl"
+
+layout (std430, binding = 1) readonly buffer KeysIn {
+    uint keysIn[];
+};
+
+layout (std430, binding = 2) readonly buffer ValuesIn {
+    uint valuesIn[];
+};
+
+layout (std430, binding = 3) readonly buffer BlockOffsets {
+    uint blockOffsets[];    // scanned counts, [digit * numBlocks + block]
+};
+
+layout (std430, binding = 4) writeonly buffer KeysOut {
+    uint keysOut[];
+};
+
+layout (std430, binding = 5) writeonly buffer ValuesOut {
+    uint valuesOut[];
+};
+
+uniform uint count;
+uniform uint shift;
+uniform uint numBlocks;
+
+// Per-thread digit counts, two 16-bit counters per uint: [word * THREADS + thread].
+// They are scanned in CHUNKS runs of CHUNK_SIZE threads per word, then over the runs.
+const uint WORDS = RADIX_SIZE / 2u;
+const uint CHUNKS = THREADS / WORDS;
+const uint CHUNK_SIZE = THREADS / CHUNKS;
+shared uint packedCounts[WORDS * THREADS];
+shared uint chunkOffsets[WORDS * CHUNKS];
+
+void main() {
+    uint thread = gl_LocalInvocationID.x;
+    uint block = workGroupIndex();
+    if (block >= numBlocks) {
+        return;     // past the last row's blocks
+    }
+    // Each thread owns consecutive keys, so thread order is key order
+    uint first = block * BLOCK_SIZE + thread * ITEMS_PER_THREAD;
+
+    // 1. count this thread's digits; only this thread writes its column
+    for (uint word = 0u; word < WORDS; word++) {
+        packedCounts[word * THREADS + thread] = 0u;
+    }
+    uint keys[ITEMS_PER_THREAD];
+    uint digits[ITEMS_PER_THREAD];
+    for (uint item = 0u; item < ITEMS_PER_THREAD; item++) {
+        keys[item] = first + item < count ? keysIn[first + item] : 0u;
+        digits[item] = (keys[item] >> shift) & (RADIX_SIZE - 1u);
+        if (first + item < count) {
+            packedCounts[(digits[item] >> 1u) * THREADS + thread] += 1u << ((digits[item] & 1u) * 16u);
+        }
+    }
+    barrier();
+
+    // 2. exclusive scan inside each run; every thread takes one run of one word.
+    // A block holds at most BLOCK_SIZE keys, so no 16-bit counter can overflow.
+    uint run = (thread / CHUNKS) * THREADS + (thread % CHUNKS) * CHUNK_SIZE;
+    uint running = 0u;
+    for (uint i = 0u; i < CHUNK_SIZE; i++) {
+        uint value = packedCounts[run + i];
+        packedCounts[run + i] = running;
+        running += value;
+    }
+    chunkOffsets[thread] = running;
+    barrier();
+
+    // 3. exclusive scan of the run totals of each word
+    if (thread < WORDS) {
+        running = 0u;
+        for (uint chunk = 0u; chunk < CHUNKS; chunk++) {
+            uint value = chunkOffsets[thread * CHUNKS + chunk];
+            chunkOffsets[thread * CHUNKS + chunk] = running;
+            running += value;
+        }
+    }
+    barrier();
+
+    // 4. keys with this digit in earlier threads, then earlier in this thread
+    for (uint item = 0u; item < ITEMS_PER_THREAD; item++) {
+        if (first + item >= count) {
+            break;
+        }
+        uint digit = digits[item];
+        uint word = digit >> 1u;
+        uint prefix = packedCounts[word * THREADS + thread] + chunkOffsets[word * CHUNKS + thread / CHUNK_SIZE];
+        uint rank = (prefix >> ((digit & 1u) * 16u)) & 0xFFFFu;
+        for (uint earlier = 0u; earlier < item; earlier++) {
+            rank += digits[earlier] == digit ? 1u : 0u;
+        }
+
+        uint destination = blockOffsets[digit * numBlocks + block] + rank;
+        keysOut[destination] = keys[item];
+        valuesOut[destination] = valuesIn[first + item];
+    }
+}
@@ -1,10 +1,37 @@
 #version 330 core
 
+// Point-size mapping; overridden by the Shader class through #defines
+#ifndef POINT_SIZE_OFFSET
+#define POINT_SIZE_OFFSET 0.5
+#endif
+#ifndef POINT_SIZE_DIVISOR
+#define POINT_SIZE_DIVISOR 0.23
+#endif
+// Points whose rotated z is below this are culled; -2 keeps the whole sphere
+#ifndef BACK_CULL_Z
+#define BACK_CULL_Z -2.0
+#endif
+// Round-point technique, see enum PointMode in include/point_modes.h
+#ifndef POINT_MODE
+#define POINT_MODE 0.0
+#endif
+
 layout (location = 0) in vec3 aPos;
-uniform mat4 rotation;
+
+#include "frame_constants.glsl"
+
+#include "point_sprite.glsl"
 
 void main() {
-    gl_Position = rotation * vec4(aPos, 1.0);
+    vec4 rotated = rotation * vec4(aPos, 1.0);
+    if (rotated.z < BACK_CULL_Z) {
+        gl_Position = vec4(2.0, 2.0, 2.0, 1.0);     // Outside clip space, never rasterized
+        gl_PointSize = 1.0;
+        return;
+    }
+
+    gl_Position = projection * rotated;
 
-    gl_PointSize = (gl_Position.z + 0.5) / 0.23;     // Map z: [-1, 1] to PointSize: [0, ]
+    float diameter = (gl_Position.z + POINT_SIZE_OFFSET) / POINT_SIZE_DIVISOR * pointScale.x;     // Map z: [-1, 1] to PointSize: [0, ]
+    gl_PointSize = pointSpriteSize(diameter);
 }
\ No newline at end of file
@@ -0,0 +1,28 @@
+#version 450 core
+#extension GL_GOOGLE_include_directive : require
+
+// SPIR-V build of vertex.glsl; compile with glslangValidator -G
+layout (constant_id = 0) const float POINT_SIZE_OFFSET = 0.5;
+layout (constant_id = 1) const float POINT_SIZE_DIVISOR = 0.23;
+layout (constant_id = 3) const float BACK_CULL_Z = -2.0;
+layout (constant_id = 4) const float POINT_MODE = 0.0;
+
+layout (location = 0) in vec3 aPos;
+
+#include "frame_constants.glsl"
+
+#include "point_sprite.glsl"
+
+void main() {
+    vec4 rotated = rotation * vec4(aPos, 1.0);
+    if (rotated.z < BACK_CULL_Z) {
+        gl_Position = vec4(2.0, 2.0, 2.0, 1.0);     // Outside clip space, never rasterized
+        gl_PointSize = 1.0;
+        return;
+    }
+
+    gl_Position = projection * rotated;
+
+    float diameter = (gl_Position.z + POINT_SIZE_OFFSET) / POINT_SIZE_DIVISOR * pointScale.x;     // Map z: [-1, 1] to PointSize: [0, ]
+    gl_PointSize = pointSpriteSize(diameter);
+}